@@ -0,0 +1,311 @@
+#include <getopt.h>        // getopt
+#include <inttypes.h>      // PRIu64
+#include <stdio.h>         // printf, sscanf
+#include <stdlib.h>        // EXIT_SUCCESS, setenv
+#include <sys/resource.h>  // getrusage
+#include <sys/wait.h>      // waitpid
+#include <unistd.h>        // fork, pipe
+
+#include <wlr/backend/headless.h>  // wlr_headless_add_output
+#include <wlr/util/log.h>          // wlr_log_init, wlr_log
+
+#include "client.h"   // ACNCageBenchClient_run
+#include "latency.h"  // ACNCageLatency_now
+#include "output.h"   // ACNCageOutput
+#include "server.h"   // ACNCageServer
+
+#define MAX_CLIENTS 64
+
+// Time left to the clients, to report before the compositor stops
+#define CLIENT_GRACE_MS 1000
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_MSEC 1000000
+
+struct Bench_Params {
+    int outputs;  // Virtual outputs
+    int outputWidth;
+    int outputHeight;
+
+    int clients;  // Synthetic clients
+    int rate;     // Commits per second, 0 to follow frame callbacks
+    int bufferWidth;
+    int bufferHeight;
+
+    int durationMs;
+};
+
+struct Bench_Client {
+    pid_t pid;
+    int resultFd;  // Read end of the pipe carrying the client result
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Print_Usage(const char* program);
+static int Parse_Args(int argc, char* argv[], struct Bench_Params* params);
+static int Parse_Size(const char* arg, int* width, int* height);
+static int Spawn_Client(const struct Bench_Params* params,
+                        const char* socket,
+                        struct Bench_Client* client);
+static int Collect_Client(struct Bench_Client* client,
+                          struct ACNCageBenchClientResult* result);
+static double Rusage_Seconds(const struct rusage* usage);
+
+/** Benchmark end timer **/
+static int End_Timer(void* data);
+
+/****************************************/
+
+int main(int argc, char* argv[]) {
+    struct Bench_Params params = {
+        .outputs = 1,
+        .outputWidth = 1920,
+        .outputHeight = 1080,
+        .clients = 1,
+        .rate = 60,
+        .bufferWidth = 1280,
+        .bufferHeight = 720,
+        .durationMs = 10000,
+    };
+    if (Parse_Args(argc, argv, &params) != 0) {
+        Print_Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    wlr_log_init(WLR_ERROR, NULL);
+
+    // Software rendering, no input devices: runs on a plain Linux box
+    setenv("WLR_RENDERER", "pixman", false);
+
+    struct ACNCageServer server = {0};
+    if (ACNCageConfig_load(&server.config) != 0) return EXIT_FAILURE;
+
+    // Headless, whatever ACNCAGE_BACKEND says, w. its single output sized as asked
+    server.config.backend = ACNCAGE_BACKEND_HEADLESS;
+    server.config.mode.width = params.outputWidth;
+    server.config.mode.height = params.outputHeight;
+
+    if (ACNCageServer_init(&server) != 0 ||
+        ACNCageServer_CreateInterfaces(&server) != 0 ||
+        ACNCageServer_CreateListeners(&server) != 0) {
+        wlr_log(WLR_ERROR, "Failed to set up ACNCageServer");
+        ACNCageServer_destroy(&server);
+        return EXIT_FAILURE;
+    }
+
+    // The other virtual outputs, announced once the backend starts
+    for (int i = 1; i < params.outputs; ++i) {
+        if (wlr_headless_add_output(server.backend, params.outputWidth,
+                                    params.outputHeight) == NULL)
+            wlr_log(WLR_ERROR, "Failed to add headless output");
+    }
+
+    // Opened by ACNCageServer_init
+    const char* socket = server.socket;
+
+    // Clients are forked before the backend starts, so they inherit little
+    struct Bench_Client clients[MAX_CLIENTS];
+    int spawned = 0;
+    for (; spawned < params.clients; ++spawned)
+        if (Spawn_Client(&params, socket, &clients[spawned]) != 0) break;
+
+    if (!wlr_backend_start(server.backend)) {
+        wlr_log(WLR_ERROR, "Failed to start wlr_backend");
+        // Clients lose their connection, and exit on their own
+        ACNCageServer_destroy(&server);
+        return EXIT_FAILURE;
+    }
+
+    struct wl_event_source* endTimer = wl_event_loop_add_timer(
+        wl_display_get_event_loop(server.wl_display), End_Timer, server.wl_display);
+    wl_event_source_timer_update(endTimer, params.durationMs + CLIENT_GRACE_MS);
+
+    struct rusage usageStart, usageEnd;
+    getrusage(RUSAGE_SELF, &usageStart);
+    const int64_t startNsec = ACNCageLatency_now();
+
+    wl_display_run(server.wl_display);
+
+    const double elapsed = (double)(ACNCageLatency_now() - startNsec) / NSEC_PER_SEC;
+    getrusage(RUSAGE_SELF, &usageEnd);
+    wl_event_source_remove(endTimer);
+
+    // Compositor side
+    int outputCount = 0;
+    uint64_t framesRendered = 0, framesSkipped = 0;
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server.outputs, link) {
+        ++outputCount;
+        framesRendered += output->scheduler.framesRendered;
+        framesSkipped += output->scheduler.framesSkipped;
+    }
+
+    // Client side
+    int failures = params.clients - spawned;
+    struct ACNCageBenchClientResult total = {0};
+    for (int i = 0; i < spawned; ++i) {
+        struct ACNCageBenchClientResult result = {0};
+        if (Collect_Client(&clients[i], &result) != 0) {
+            ++failures;
+            continue;
+        }
+        total.commits += result.commits;
+        total.framesDone += result.framesDone;
+        ACNCageLatency_merge(&total.latency, &result.latency);
+    }
+
+    const double clientSeconds = (double)params.durationMs / 1000;
+    const double cpu = Rusage_Seconds(&usageEnd) - Rusage_Seconds(&usageStart);
+
+    printf("outputs=%d\n", outputCount);
+    printf("clients=%d\n", params.clients - failures);
+    printf("compositor_fps=%.1f\n",
+           outputCount > 0 ? (double)framesRendered / elapsed / outputCount : 0);
+    printf("compositor_frames_rendered=%" PRIu64 "\n", framesRendered);
+    printf("compositor_frames_skipped=%" PRIu64 "\n", framesSkipped);
+    printf("client_commits_per_s=%.1f\n", (double)total.commits / clientSeconds);
+    printf("client_frames_per_s=%.1f\n", (double)total.framesDone / clientSeconds);
+    printf("commit_to_frame_done_p50_ms=%.3f\n",
+           (double)ACNCageLatency_percentile(&total.latency, 50) / NSEC_PER_MSEC);
+    printf("commit_to_frame_done_p99_ms=%.3f\n",
+           (double)ACNCageLatency_percentile(&total.latency, 99) / NSEC_PER_MSEC);
+    printf("commit_to_frame_done_max_ms=%.3f\n",
+           (double)total.latency.maxNsec / NSEC_PER_MSEC);
+    printf("cpu_time_s=%.3f\n", cpu);
+    printf("cpu_percent=%.1f\n", elapsed > 0 ? cpu / elapsed * 100 : 0);
+    printf("max_rss_kib=%ld\n", usageEnd.ru_maxrss);
+
+    wl_display_destroy_clients(server.wl_display);
+    ACNCageServer_destroy(&server);
+
+    return failures == 0 && outputCount == params.outputs ? EXIT_SUCCESS
+                                                          : EXIT_FAILURE;
+}
+
+static void Print_Usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -o <count>   virtual outputs (default 1)\n"
+            "  -s <WxH>     output size (default 1920x1080)\n"
+            "  -c <count>   synthetic clients (default 1, max %d)\n"
+            "  -r <hz>      client commit rate, 0 to follow frame callbacks "
+            "(default 60)\n"
+            "  -b <WxH>     client buffer size (default 1280x720)\n"
+            "  -d <sec>     duration (default 10)\n",
+            program, MAX_CLIENTS);
+}
+
+static int Parse_Args(int argc, char* argv[], struct Bench_Params* params) {
+    int option;
+    while ((option = getopt(argc, argv, "o:s:c:r:b:d:h")) != -1) {
+        switch (option) {
+            case 'o':
+                params->outputs = atoi(optarg);
+                break;
+            case 's':
+                if (Parse_Size(optarg, &params->outputWidth, &params->outputHeight))
+                    return -1;
+                break;
+            case 'c':
+                params->clients = atoi(optarg);
+                break;
+            case 'r':
+                params->rate = atoi(optarg);
+                break;
+            case 'b':
+                if (Parse_Size(optarg, &params->bufferWidth, &params->bufferHeight))
+                    return -1;
+                break;
+            case 'd':
+                params->durationMs = atoi(optarg) * 1000;
+                break;
+            default:
+                return -1;
+        }
+    }
+
+    if (params->outputs < 1 || params->clients < 0 ||
+        params->clients > MAX_CLIENTS || params->rate < 0 || params->durationMs <= 0)
+        return -1;
+    return 0;
+}
+
+static int Parse_Size(const char* arg, int* width, int* height) {
+    if (sscanf(arg, "%dx%d", width, height) != 2 || *width <= 0 || *height <= 0)
+        return -1;
+    return 0;
+}
+
+static int Spawn_Client(const struct Bench_Params* params,
+                        const char* socket,
+                        struct Bench_Client* client) {
+    int fds[2];
+    if (pipe(fds) == -1) {
+        wlr_log_errno(WLR_ERROR, "Failed to create client pipe");
+        return -1;
+    }
+
+    client->pid = fork();
+    if (client->pid == -1) {
+        wlr_log_errno(WLR_ERROR, "Failed to fork client");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (client->pid == 0) {
+        // Client process, never returns
+        close(fds[0]);
+        struct ACNCageBenchClientParams clientParams = {
+            .socket = socket,
+            .width = params->bufferWidth,
+            .height = params->bufferHeight,
+            .rate = params->rate,
+            .durationMs = params->durationMs,
+        };
+        struct ACNCageBenchClientResult result = {0};
+        int status = ACNCageBenchClient_run(&clientParams, &result);
+        if (status == 0 && write(fds[1], &result, sizeof(result)) != sizeof(result))
+            status = -1;
+        _exit(status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    client->resultFd = fds[0];
+    return 0;
+}
+
+static int Collect_Client(struct Bench_Client* client,
+                          struct ACNCageBenchClientResult* result) {
+    size_t received = 0;
+    while (received < sizeof(*result)) {
+        ssize_t count = read(client->resultFd, (char*)result + received,
+                             sizeof(*result) - received);
+        if (count <= 0) break;
+        received += (size_t)count;
+    }
+    close(client->resultFd);
+
+    int status = 0;
+    waitpid(client->pid, &status, 0);
+    if (received != sizeof(*result) || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS) {
+        wlr_log(WLR_ERROR, "Client %d failed", client->pid);
+        return -1;
+    }
+    return 0;
+}
+
+static double Rusage_Seconds(const struct rusage* usage) {
+    return (double)(usage->ru_utime.tv_sec + usage->ru_stime.tv_sec) +
+           (double)(usage->ru_utime.tv_usec + usage->ru_stime.tv_usec) / 1000000;
+}
+
+// Raise by the event loop, once the benchmark duration has elapsed
+static int End_Timer(void* data) {
+    struct wl_display* wl_display = data;
+    wl_display_terminate(wl_display);
+    return 0;
+}
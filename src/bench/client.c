@@ -0,0 +1,370 @@
+#include "client.h"
+
+#include <errno.h>     // errno
+#include <fcntl.h>     // O_RDWR
+#include <poll.h>      // poll
+#include <stdbool.h>   // bool
+#include <stdio.h>     // snprintf, fprintf
+#include <string.h>    // strcmp, strerror
+#include <sys/mman.h>  // mmap, shm_open
+#include <unistd.h>    // ftruncate, getpid
+
+#include <wayland-client.h>  // wl_display
+
+#include "xdg-shell-client-protocol.h"  // xdg_wm_base
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_MSEC 1000000
+
+#define BUFFER_COUNT 2
+
+struct Bench_Buffer {
+    struct wl_buffer* wl_buffer;
+    uint32_t* pixels;
+    bool busy;  // Held by the compositor until released
+};
+
+struct Bench_Client {
+    const struct ACNCageBenchClientParams* params;
+    struct ACNCageBenchClientResult* result;
+
+    // Globals
+    struct wl_display* wl_display;
+    struct wl_registry* wl_registry;
+    struct wl_compositor* wl_compositor;
+    struct wl_shm* wl_shm;
+    struct xdg_wm_base* xdg_wm_base;
+
+    // Window
+    struct wl_surface* wl_surface;
+    struct xdg_surface* xdg_surface;
+    struct xdg_toplevel* xdg_toplevel;
+    bool configured;
+    bool closed;
+
+    // Frames
+    struct Bench_Buffer buffers[BUFFER_COUNT];
+    void* pixels;  // Mapping shared by all buffers
+    size_t poolSize;
+    struct wl_callback* frameCallback;
+    int64_t frameCommitNsec;  // Commit time of the frame callback in flight
+    uint32_t frameIndex;
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Create_Window(struct Bench_Client* client);
+static int Create_Buffers(struct Bench_Client* client);
+static void Destroy_Client(struct Bench_Client* client);
+static bool Commit_Frame(struct Bench_Client* client);
+static int Dispatch_Events(struct Bench_Client* client, int timeoutMs);
+
+/** Registry **/
+static void Registry_Global(void* data,
+                            struct wl_registry* wl_registry,
+                            uint32_t name,
+                            const char* interface,
+                            uint32_t version);
+static void Registry_GlobalRemove(void* data,
+                                  struct wl_registry* wl_registry,
+                                  uint32_t name);
+
+/** Shell **/
+static void WmBase_Ping(void* data,
+                        struct xdg_wm_base* xdg_wm_base,
+                        uint32_t serial);
+static void XdgSurface_Configure(void* data,
+                                 struct xdg_surface* xdg_surface,
+                                 uint32_t serial);
+static void XdgToplevel_Configure(void* data,
+                                  struct xdg_toplevel* xdg_toplevel,
+                                  int32_t width,
+                                  int32_t height,
+                                  struct wl_array* states);
+static void XdgToplevel_Close(void* data, struct xdg_toplevel* xdg_toplevel);
+
+/** Frames **/
+static void Buffer_Release(void* data, struct wl_buffer* wl_buffer);
+static void Frame_Done(void* data, struct wl_callback* wl_callback, uint32_t time);
+
+static const struct wl_registry_listener registryListener = {
+    .global = Registry_Global,
+    .global_remove = Registry_GlobalRemove,
+};
+static const struct xdg_wm_base_listener wmBaseListener = {
+    .ping = WmBase_Ping,
+};
+static const struct xdg_surface_listener xdgSurfaceListener = {
+    .configure = XdgSurface_Configure,
+};
+static const struct xdg_toplevel_listener xdgToplevelListener = {
+    .configure = XdgToplevel_Configure,
+    .close = XdgToplevel_Close,
+};
+static const struct wl_buffer_listener bufferListener = {
+    .release = Buffer_Release,
+};
+static const struct wl_callback_listener frameListener = {
+    .done = Frame_Done,
+};
+
+/****************************************/
+
+int ACNCageBenchClient_run(const struct ACNCageBenchClientParams* params,
+                           struct ACNCageBenchClientResult* result) {
+    struct Bench_Client client = {.params = params, .result = result};
+
+    client.wl_display = wl_display_connect(params->socket);
+    if (client.wl_display == NULL) {
+        fprintf(stderr, "Failed to connect to %s\n", params->socket);
+        return -1;
+    }
+
+    if (Create_Window(&client) != 0 || Create_Buffers(&client) != 0) {
+        Destroy_Client(&client);
+        return -1;
+    }
+
+    const int64_t intervalNsec =
+        params->rate > 0 ? NSEC_PER_SEC / params->rate : 0;
+    int64_t now = ACNCageLatency_now();
+    const int64_t endNsec = now + (int64_t)params->durationMs * NSEC_PER_MSEC;
+    int64_t nextCommitNsec = now;
+
+    while (now < endNsec && !client.closed) {
+        // Fixed rate, or as fast as frame callbacks allow
+        bool due = intervalNsec > 0 ? now >= nextCommitNsec
+                                    : client.frameCallback == NULL;
+        if (client.configured && due) {
+            Commit_Frame(&client);
+            while (intervalNsec > 0 && nextCommitNsec <= now)
+                nextCommitNsec += intervalNsec;
+        }
+
+        // Wait for events, until the next commit is due
+        int64_t wakeNsec = endNsec;
+        if (intervalNsec > 0 && nextCommitNsec < endNsec) wakeNsec = nextCommitNsec;
+        int timeoutMs = (int)((wakeNsec - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC);
+        if (Dispatch_Events(&client, timeoutMs) != 0) {
+            Destroy_Client(&client);
+            return -1;
+        }
+
+        now = ACNCageLatency_now();
+    }
+
+    Destroy_Client(&client);
+    return 0;
+}
+
+static int Create_Window(struct Bench_Client* client) {
+    client->wl_registry = wl_display_get_registry(client->wl_display);
+    wl_registry_add_listener(client->wl_registry, &registryListener, client);
+    if (wl_display_roundtrip(client->wl_display) == -1) return -1;
+
+    if (client->wl_compositor == NULL || client->wl_shm == NULL ||
+        client->xdg_wm_base == NULL) {
+        fprintf(stderr, "Compositor is missing required globals\n");
+        return -1;
+    }
+
+    client->wl_surface = wl_compositor_create_surface(client->wl_compositor);
+    client->xdg_surface =
+        xdg_wm_base_get_xdg_surface(client->xdg_wm_base, client->wl_surface);
+    xdg_surface_add_listener(client->xdg_surface, &xdgSurfaceListener, client);
+    client->xdg_toplevel = xdg_surface_get_toplevel(client->xdg_surface);
+    xdg_toplevel_add_listener(client->xdg_toplevel, &xdgToplevelListener, client);
+    xdg_toplevel_set_title(client->xdg_toplevel, "acncage-bench");
+
+    // Initial commit, without a buffer, to receive the first configure
+    wl_surface_commit(client->wl_surface);
+    if (wl_display_roundtrip(client->wl_display) == -1) return -1;
+
+    return 0;
+}
+
+static int Create_Buffers(struct Bench_Client* client) {
+    const struct ACNCageBenchClientParams* params = client->params;
+    const int stride = params->width * 4;
+    const size_t bufferSize = (size_t)stride * params->height;
+    client->poolSize = bufferSize * BUFFER_COUNT;
+
+    // Anonymous shared memory, backing every buffer
+    char name[64];
+    snprintf(name, sizeof(name), "/acncage-bench-%d", getpid());
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        fprintf(stderr, "shm_open: %s\n", strerror(errno));
+        return -1;
+    }
+    shm_unlink(name);
+
+    if (ftruncate(fd, (off_t)client->poolSize) == -1) {
+        fprintf(stderr, "ftruncate: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    client->pixels =
+        mmap(NULL, client->poolSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (client->pixels == MAP_FAILED) {
+        fprintf(stderr, "mmap: %s\n", strerror(errno));
+        client->pixels = NULL;
+        close(fd);
+        return -1;
+    }
+
+    struct wl_shm_pool* pool =
+        wl_shm_create_pool(client->wl_shm, fd, (int32_t)client->poolSize);
+    for (int i = 0; i < BUFFER_COUNT; ++i) {
+        struct Bench_Buffer* buffer = &client->buffers[i];
+        buffer->wl_buffer = wl_shm_pool_create_buffer(
+            pool, (int32_t)(bufferSize * i), params->width, params->height, stride,
+            WL_SHM_FORMAT_XRGB8888);
+        buffer->pixels = (uint32_t*)((uint8_t*)client->pixels + bufferSize * i);
+        wl_buffer_add_listener(buffer->wl_buffer, &bufferListener, buffer);
+    }
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    return 0;
+}
+
+static void Destroy_Client(struct Bench_Client* client) {
+    if (client->frameCallback != NULL) wl_callback_destroy(client->frameCallback);
+    for (int i = 0; i < BUFFER_COUNT; ++i)
+        if (client->buffers[i].wl_buffer != NULL)
+            wl_buffer_destroy(client->buffers[i].wl_buffer);
+    if (client->pixels != NULL) munmap(client->pixels, client->poolSize);
+
+    if (client->xdg_toplevel != NULL) xdg_toplevel_destroy(client->xdg_toplevel);
+    if (client->xdg_surface != NULL) xdg_surface_destroy(client->xdg_surface);
+    if (client->wl_surface != NULL) wl_surface_destroy(client->wl_surface);
+
+    if (client->xdg_wm_base != NULL) xdg_wm_base_destroy(client->xdg_wm_base);
+    if (client->wl_shm != NULL) wl_shm_destroy(client->wl_shm);
+    if (client->wl_compositor != NULL) wl_compositor_destroy(client->wl_compositor);
+    if (client->wl_registry != NULL) wl_registry_destroy(client->wl_registry);
+
+    wl_display_disconnect(client->wl_display);
+}
+
+static bool Commit_Frame(struct Bench_Client* client) {
+    const struct ACNCageBenchClientParams* params = client->params;
+
+    struct Bench_Buffer* buffer = NULL;
+    for (int i = 0; i < BUFFER_COUNT && buffer == NULL; ++i)
+        if (!client->buffers[i].busy) buffer = &client->buffers[i];
+    if (buffer == NULL) return false;  // Compositor is behind, skip this commit
+
+    // Repaint every pixel, so that each commit is a full upload
+    const uint32_t color = 0xFF000000 | (client->frameIndex++ * 0x010203);
+    const size_t pixelCount = (size_t)params->width * params->height;
+    for (size_t i = 0; i < pixelCount; ++i) buffer->pixels[i] = color;
+
+    wl_surface_attach(client->wl_surface, buffer->wl_buffer, 0, 0);
+    wl_surface_damage(client->wl_surface, 0, 0, params->width, params->height);
+
+    // Measure commit to frame done, one frame callback at a time
+    if (client->frameCallback == NULL) {
+        client->frameCallback = wl_surface_frame(client->wl_surface);
+        wl_callback_add_listener(client->frameCallback, &frameListener, client);
+        client->frameCommitNsec = ACNCageLatency_now();
+    }
+
+    wl_surface_commit(client->wl_surface);
+    buffer->busy = true;
+    ++client->result->commits;
+    return true;
+}
+
+static int Dispatch_Events(struct Bench_Client* client, int timeoutMs) {
+    struct wl_display* wl_display = client->wl_display;
+
+    while (wl_display_prepare_read(wl_display) != 0)
+        if (wl_display_dispatch_pending(wl_display) == -1) return -1;
+    wl_display_flush(wl_display);
+
+    struct pollfd pollfd = {.fd = wl_display_get_fd(wl_display), .events = POLLIN};
+    int ready = poll(&pollfd, 1, timeoutMs);
+    if (ready <= 0) {
+        wl_display_cancel_read(wl_display);
+        return ready == -1 && errno != EINTR ? -1 : 0;
+    }
+
+    if (wl_display_read_events(wl_display) == -1) return -1;
+    return wl_display_dispatch_pending(wl_display) == -1 ? -1 : 0;
+}
+
+static void Registry_Global(void* data,
+                            struct wl_registry* wl_registry,
+                            uint32_t name,
+                            const char* interface,
+                            uint32_t version) {
+    struct Bench_Client* client = data;
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        client->wl_compositor = wl_registry_bind(
+            wl_registry, name, &wl_compositor_interface, version < 4 ? version : 4);
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        client->wl_shm = wl_registry_bind(wl_registry, name, &wl_shm_interface, 1);
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        client->xdg_wm_base =
+            wl_registry_bind(wl_registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(client->xdg_wm_base, &wmBaseListener, client);
+    }
+}
+
+static void Registry_GlobalRemove(void* data __attribute__((unused)),
+                                  struct wl_registry* wl_registry
+                                  __attribute__((unused)),
+                                  uint32_t name __attribute__((unused))) {}
+
+static void WmBase_Ping(void* data __attribute__((unused)),
+                        struct xdg_wm_base* xdg_wm_base,
+                        uint32_t serial) {
+    xdg_wm_base_pong(xdg_wm_base, serial);
+}
+
+static void XdgSurface_Configure(void* data,
+                                 struct xdg_surface* xdg_surface,
+                                 uint32_t serial) {
+    struct Bench_Client* client = data;
+    xdg_surface_ack_configure(xdg_surface, serial);
+    client->configured = true;
+}
+
+// The buffer size is fixed by the benchmark, the suggested size is ignored
+static void XdgToplevel_Configure(void* data __attribute__((unused)),
+                                  struct xdg_toplevel* xdg_toplevel
+                                  __attribute__((unused)),
+                                  int32_t width __attribute__((unused)),
+                                  int32_t height __attribute__((unused)),
+                                  struct wl_array* states __attribute__((unused))) {}
+
+static void XdgToplevel_Close(void* data,
+                              struct xdg_toplevel* xdg_toplevel
+                              __attribute__((unused))) {
+    struct Bench_Client* client = data;
+    client->closed = true;
+}
+
+static void Buffer_Release(void* data,
+                           struct wl_buffer* wl_buffer __attribute__((unused))) {
+    struct Bench_Buffer* buffer = data;
+    buffer->busy = false;
+}
+
+static void Frame_Done(void* data,
+                       struct wl_callback* wl_callback,
+                       uint32_t time __attribute__((unused))) {
+    struct Bench_Client* client = data;
+
+    ACNCageLatency_record(&client->result->latency,
+                          ACNCageLatency_now() - client->frameCommitNsec);
+    ++client->result->framesDone;
+
+    wl_callback_destroy(wl_callback);
+    client->frameCallback = NULL;
+}
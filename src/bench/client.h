@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>  // uint64_t
+
+#include "latency.h"  // ACNCageLatencyHistogram
+
+struct ACNCageBenchClientParams {
+    const char* socket;  // Wayland socket to connect to
+    int width;           // Buffer size
+    int height;
+    int rate;        // Commits per second, 0 to commit on every frame done
+    int durationMs;  // Time spent committing
+};
+
+struct ACNCageBenchClientResult {
+    uint64_t commits;
+    uint64_t framesDone;
+    struct ACNCageLatencyHistogram latency;  // Commit to frame done
+};
+
+/**
+ * Run a synthetic xdg-shell client, committing shm buffers until the duration
+ * has elapsed
+ * :param params: client behavior
+ * :param result: collected statistics
+ * :return: Success 0, Error -1
+ */
+int ACNCageBenchClient_run(const struct ACNCageBenchClientParams* params,
+                           struct ACNCageBenchClientResult* result);
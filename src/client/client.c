@@ -0,0 +1,284 @@
+#include "client.h"
+
+#include <inttypes.h>  // PRId64, PRIu64
+#include <stdlib.h>    // calloc, free
+
+#include <wayland-server-protocol.h>   // wl_callback_send_done
+#include <wlr/config.h>                // WLR_HAS_XWAYLAND
+#include <wlr/types/wlr_buffer.h>      // wlr_buffer_get_shm, wlr_client_buffer
+#include <wlr/types/wlr_compositor.h>  // wlr_surface
+#include <wlr/util/log.h>              // wlr_log
+#if WLR_HAS_XWAYLAND
+#include <wlr/xwayland.h>  // wlr_xwayland, wlr_xwayland_server
+#endif
+
+#include "damage.h"    // ACNCageDamage_area
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+#include "latency.h"   // ACNCageLatency_now
+#include "output.h"    // ACNCageOutput
+#include "server.h"    // ACNCageServer
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_MSEC 1000000
+// Assumed when no output advertises its refresh rate
+#define FALLBACK_REFRESH_MHZ 60000
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Update_Commit_Rate(struct ACNCageClient* client);
+static int Max_Refresh_Mhz(struct ACNCageServer* server);
+static bool Is_Xwayland(struct ACNCageClient* client);
+static void Release_Held_Callbacks(struct ACNCageClientSurface* clientSurface,
+                                   uint32_t msec);
+static void Destroy_ClientSurface(struct ACNCageClientSurface* clientSurface);
+
+/** Client destroy **/
+static void Client_Destroy(struct wl_listener* listener, void* data);
+
+/** Surface commit **/
+static void Surface_Commit(struct wl_listener* listener, void* data);
+
+/** Surface destroy **/
+static void Surface_Destroy(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Client_Destroy)
+ACNCAGE_DISPATCH_DEFINE(Surface_Commit)
+ACNCAGE_DISPATCH_DEFINE(Surface_Destroy)
+
+int ACNCageClient_create(struct ACNCageServer* server, struct wl_client* wl_client) {
+    struct ACNCageClient* client = calloc(1, sizeof(struct ACNCageClient));
+    if (client == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageClient");
+        return -1;
+    }
+    client->wl_client = wl_client;
+    client->server = server;
+    wl_client_get_credentials(wl_client, &client->pid, NULL, NULL);
+    wl_list_init(&client->surfaces);
+
+    // Also how the client is found again, see ACNCageClient_from
+    client->clientDestroyListener.notify = ACNCAGE_DISPATCH(Client_Destroy);
+    wl_client_add_destroy_listener(wl_client, &client->clientDestroyListener);
+
+    wl_list_insert(&server->clients, &client->link);
+    return 0;
+}
+
+struct ACNCageClient* ACNCageClient_from(struct wl_client* wl_client) {
+    // Registered as picked by ACNCAGE_DISPATCH, so looked up the same way
+    struct wl_listener* listener =
+        wl_client_get_destroy_listener(wl_client, ACNCAGE_DISPATCH(Client_Destroy));
+    if (listener == NULL) return NULL;
+
+    struct ACNCageClient* client =
+        wl_container_of(listener, client, clientDestroyListener);
+    return client;
+}
+
+int ACNCageClient_TrackSurface(struct wlr_surface* surface) {
+    struct ACNCageClient* client =
+        ACNCageClient_from(wl_resource_get_client(surface->resource));
+    if (client == NULL) return 0;  // Not accounted for
+
+    struct ACNCageClientSurface* clientSurface =
+        calloc(1, sizeof(struct ACNCageClientSurface));
+    if (clientSurface == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageClientSurface");
+        return -1;
+    }
+    clientSurface->surface = surface;
+    clientSurface->client = client;
+    wl_list_init(&clientSurface->heldCallbacks);
+
+    clientSurface->surfaceCommitListener.notify = ACNCAGE_DISPATCH(Surface_Commit);
+    wl_signal_add(&surface->events.commit, &clientSurface->surfaceCommitListener);
+    clientSurface->surfaceDestroyListener.notify = ACNCAGE_DISPATCH(Surface_Destroy);
+    wl_signal_add(&surface->events.destroy, &clientSurface->surfaceDestroyListener);
+
+    wl_list_insert(&client->surfaces, &clientSurface->link);
+    return 0;
+}
+
+void ACNCageClient_ReleaseFrames(struct ACNCageServer* server,
+                                 const struct timespec* when) {
+    int64_t intervalNsec =
+        (int64_t)server->config.commitThrottleIntervalMs * NSEC_PER_MSEC;
+    uint32_t msec = (uint32_t)(when->tv_sec * 1000 + when->tv_nsec / NSEC_PER_MSEC);
+    int64_t now = 0;
+
+    struct ACNCageClient* client;
+    wl_list_for_each(client, &server->clients, link) {
+        struct ACNCageClientSurface* clientSurface;
+        wl_list_for_each(clientSurface, &client->surfaces, link) {
+            if (wl_list_empty(&clientSurface->heldCallbacks)) continue;
+
+            if (now == 0) now = ACNCageLatency_now();
+            if (client->throttled && now - clientSurface->releaseNsec < intervalNsec)
+                continue;
+
+            clientSurface->releaseNsec = now;
+            Release_Held_Callbacks(clientSurface, msec);
+        }
+    }
+}
+
+void ACNCageClient_LogStats(struct ACNCageClient* client) {
+    // Clients which never committed anything aren't worth a line
+    if (client->commits == 0 && client->framesSuppressed == 0) return;
+
+    wlr_log(WLR_INFO,
+            "Client %d: %" PRIu64 " commits, %" PRIu64 " w. a buffer, %.1f MiB "
+            "uploaded",
+            (int)client->pid, client->commits, client->bufferCommits,
+            (double)client->uploadBytes / (1024 * 1024));
+    wlr_log(WLR_INFO,
+            "Client %d: %" PRIu64 " frame callbacks suppressed while hidden, "
+            "%" PRIu64 " held back while throttled",
+            (int)client->pid, client->framesSuppressed, client->framesThrottled);
+}
+
+static void Update_Commit_Rate(struct ACNCageClient* client) {
+    struct ACNCageServer* server = client->server;
+    int64_t now = ACNCageLatency_now();
+
+    // Windows only roll on commits, & may span much more than a second
+    int64_t elapsedNsec = now - client->windowStartNsec;
+    if (elapsedNsec >= NSEC_PER_SEC) {
+        // Commits beyond what N times the fastest output could ever show
+        // Note: Idle for a whole window or more, the client is under any limit
+        int64_t limit =
+            (int64_t)server->config.commitRateLimit * Max_Refresh_Mhz(server) / 1000;
+        int64_t rate = 0;
+        if (elapsedNsec < 2 * NSEC_PER_SEC)
+            rate = (int64_t)client->windowCommits * NSEC_PER_SEC / elapsedNsec;
+        bool throttled = limit > 0 && rate > limit && !Is_Xwayland(client);
+        if (throttled != client->throttled)
+            wlr_log(WLR_INFO, "Client %d: %" PRId64 " commits/s, %s",
+                    (int)client->pid, rate,
+                    throttled ? "throttling frame callbacks"
+                              : "no longer throttled");
+
+        client->throttled = throttled;
+        client->windowStartNsec = now;
+        client->windowCommits = 0;
+    }
+    ++client->windowCommits;
+}
+
+static int Max_Refresh_Mhz(struct ACNCageServer* server) {
+    int refreshMhz = 0;
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) {
+        if (output->wlr_output->refresh > refreshMhz)
+            refreshMhz = output->wlr_output->refresh;
+    }
+    return refreshMhz > 0 ? refreshMhz : FALLBACK_REFRESH_MHZ;
+}
+
+// Xwayland commits on behalf of every X11 app, throttling it would slow them all
+static bool Is_Xwayland(struct ACNCageClient* client) {
+#if WLR_HAS_XWAYLAND
+    struct wlr_xwayland* xwayland = client->server->xwayland;
+    return xwayland != NULL && xwayland->server != NULL &&
+           xwayland->server->client == client->wl_client;
+#else
+    (void)client;
+    return false;
+#endif
+}
+
+static void Release_Held_Callbacks(struct ACNCageClientSurface* clientSurface,
+                                   uint32_t msec) {
+    struct wl_resource* resource;
+    struct wl_resource* tmp;
+    wl_resource_for_each_safe(resource, tmp, &clientSurface->heldCallbacks) {
+        // Unlinked from the held list by the surface's callback destructor
+        wl_callback_send_done(resource, msec);
+        wl_resource_destroy(resource);
+    }
+}
+
+static void Destroy_ClientSurface(struct ACNCageClientSurface* clientSurface) {
+    wl_list_remove(&clientSurface->surfaceCommitListener.link);
+    wl_list_remove(&clientSurface->surfaceDestroyListener.link);
+    wl_list_remove(&clientSurface->link);
+    free(clientSurface);
+}
+
+// Raise by the client, as part of it's self-destruction process
+// Note: Before its resources (surfaces, callbacks) are destroyed
+static void Client_Destroy(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageClient* client =
+        wl_container_of(listener, client, clientDestroyListener);
+
+    ACNCageClient_LogStats(client);
+
+    // Held callbacks are left to the resource teardown, detached from the list
+    struct ACNCageClientSurface* clientSurface;
+    struct ACNCageClientSurface* tmp;
+    wl_list_for_each_safe(clientSurface, tmp, &client->surfaces, link) {
+        struct wl_resource* resource;
+        struct wl_resource* tmpResource;
+        wl_resource_for_each_safe(resource, tmpResource,
+                                  &clientSurface->heldCallbacks) {
+            wl_list_remove(wl_resource_get_link(resource));
+            wl_list_init(wl_resource_get_link(resource));
+        }
+        Destroy_ClientSurface(clientSurface);
+    }
+
+    wl_list_remove(&client->clientDestroyListener.link);
+    wl_list_remove(&client->link);
+    free(client);
+}
+
+// Raise by the surface, when the client commits a new surface state
+static void Surface_Commit(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageClientSurface* clientSurface =
+        wl_container_of(listener, clientSurface, surfaceCommitListener);
+    struct ACNCageClient* client = clientSurface->client;
+    struct wlr_surface* surface = clientSurface->surface;
+
+    ++client->commits;
+    if (surface->current.committed & WLR_SURFACE_STATE_BUFFER) {
+        ++client->bufferCommits;
+        Update_Commit_Rate(client);
+
+        // Shared memory content gets copied into a texture, damage only
+        // Note: The committed buffer is only left as the texture's source
+        struct wlr_shm_attributes shm;
+        if (surface->buffer != NULL && surface->buffer->source != NULL &&
+            wlr_buffer_get_shm(surface->buffer->source, &shm) && shm.width > 0)
+            client->uploadBytes += ACNCageDamage_area(&surface->buffer_damage) *
+                                   (uint64_t)(shm.stride / shm.width);
+    }
+
+    // Taken out of the scene's reach, answered by ACNCageClient_ReleaseFrames
+    // Note: wlroots 0.16 can't drop or delay the commit itself
+    if (!client->throttled || wl_list_empty(&surface->current.frame_callback_list))
+        return;
+    client->framesThrottled += wl_list_length(&surface->current.frame_callback_list);
+    wl_list_insert_list(&clientSurface->heldCallbacks,
+                        &surface->current.frame_callback_list);
+    wl_list_init(&surface->current.frame_callback_list);
+}
+
+// Raise by the surface, as part of it's self-destruction process
+static void Surface_Destroy(struct wl_listener* listener,
+                            void* data __attribute__((unused))) {
+    struct ACNCageClientSurface* clientSurface =
+        wl_container_of(listener, clientSurface, surfaceDestroyListener);
+
+    // Same as the callbacks still owned by the surface
+    struct wl_resource* resource;
+    struct wl_resource* tmp;
+    wl_resource_for_each_safe(resource, tmp, &clientSurface->heldCallbacks)
+        wl_resource_destroy(resource);
+
+    Destroy_ClientSurface(clientSurface);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>    // bool
+#include <stdint.h>     // int64_t, uint32_t, uint64_t
+#include <sys/types.h>  // pid_t
+#include <time.h>       // timespec
+
+#include <wayland-server-core.h>  // wl_client, wl_listener
+
+// Per-client accounting, lives as long as the client's connection
+struct ACNCageClient {
+    struct wl_client* wl_client;
+    struct wl_list link;
+
+    struct ACNCageServer* server;
+    pid_t pid;
+    struct wl_list surfaces;  // ACNCageClientSurface.link
+
+    // Output frames on which a pending frame callback of a hidden view was
+    // held back
+    uint64_t framesSuppressed;
+
+    // Commits, over the client's lifetime
+    uint64_t commits;
+    uint64_t bufferCommits;
+    uint64_t uploadBytes;  // Damaged shm pixels, copied into textures
+
+    // Buffer commit rate, measured over 1s windows
+    int64_t windowStartNsec;
+    uint32_t windowCommits;
+    bool throttled;            // Rate went over the limit in the last window
+    uint64_t framesThrottled;  // Frame callbacks held back while throttled
+
+    // Listeners
+    struct wl_listener clientDestroyListener;
+};
+
+// Surface of a client, w. the frame callbacks held back from it
+struct ACNCageClientSurface {
+    struct wlr_surface* surface;
+    struct ACNCageClient* client;
+    struct wl_list link;
+
+    struct wl_list heldCallbacks;  // wl_callback resources
+    int64_t releaseNsec;           // Last time held callbacks were answered
+
+    // Listeners
+    struct wl_listener surfaceCommitListener;
+    struct wl_listener surfaceDestroyListener;
+};
+
+/**
+ * Start accounting for a newly connected client
+ * :param    server: server the client connected to
+ * :param wl_client: connected client
+ * :return: Success 0, Error -1
+ */
+int ACNCageClient_create(struct ACNCageServer* server, struct wl_client* wl_client);
+
+/**
+ * Find the ACNCageClient of the provided wl_client
+ * :param wl_client: client to look up
+ * :return: Success the client, Error NULL (connected before accounting began)
+ */
+struct ACNCageClient* ACNCageClient_from(struct wl_client* wl_client);
+
+/**
+ * Start accounting the commits of a newly created surface, to its client
+ * :param surface: created surface
+ * :return: Success 0, Error -1
+ */
+int ACNCageClient_TrackSurface(struct wlr_surface* surface);
+
+/**
+ * Answer the frame callbacks held back from throttled clients, at most once
+ * per throttle interval, & right away for clients no longer throttled
+ * :param server: server hosting the clients
+ * :param   when: timestamp of the output frame
+ */
+void ACNCageClient_ReleaseFrames(struct ACNCageServer* server,
+                                 const struct timespec* when);
+
+/**
+ * Log the statistics of the provided ACNCageClient
+ * :param client: client to report on
+ */
+void ACNCageClient_LogStats(struct ACNCageClient* client);
@@ -0,0 +1,336 @@
+#include "config.h"
+
+#include <errno.h>   // errno
+#include <stdio.h>   // sscanf
+#include <stdlib.h>  // getenv, strtol, strtof
+#include <string.h>  // strcmp
+
+#include <wlr/util/log.h>  // wlr_log
+
+/***** Static function declarations *****/
+
+/** Environment readers, value is left untouched when the variable isn't set **/
+static int Read_Bool(const char* name, bool* value);
+static int Read_Int(const char* name, int min, int max, int* value);
+static int Read_Float(const char* name, float min, float max, float* value);
+static int Read_String(const char* name, const char** value);
+static int Read_Choice(const char* name,
+                       const char* const choices[],
+                       int count,
+                       int* value);
+static int Read_Mode(const char* name, struct ACNCageModeSpec* value);
+
+/****************************************/
+
+int ACNCageConfig_load(struct ACNCageConfig* config) {
+    if (config == NULL) return -1;
+
+    // Defaults
+    *config = (struct ACNCageConfig){
+        .backend = ACNCAGE_BACKEND_AUTO,
+        .drmDevice = NULL,
+        .renderer = ACNCAGE_RENDERER_AUTO,
+        .renderDelay = true,
+        .maxRenderTimeMs = 0,
+        .directScanout = true,
+        .xwayland = true,
+        .mirror = false,
+        .scale = 1.0f,
+        .screencopy = ACNCAGE_SCREENCOPY_ON,
+        .hiddenFrames = ACNCAGE_HIDDEN_FRAMES_THROTTLE,
+        .hiddenFrameIntervalMs = 1000,
+        .commitRateLimit = 4,
+        .commitThrottleIntervalMs = 100,
+        .modePolicy = ACNCAGE_MODE_POLICY_PREFERRED,
+        .mode = {0},
+        .maxMode = {0},
+        .adaptiveSync = ACNCAGE_ADAPTIVE_SYNC_OFF,
+        .staticRefreshHz = 0,
+        .keymapCacheDir = NULL,
+        .pointerCoalescing = ACNCAGE_POINTER_COALESCING_NONE,
+        .slabPrewarm = 0,
+        .schedPolicy = ACNCAGE_SCHED_OTHER,
+        .schedPriority = 10,
+        .cpuAffinity = NULL,
+        .memoryLock = false,
+        .stackPrefaultKiB = 0,
+        .tracePath = NULL,
+        .dispatchTiming = false,
+        .dispatchBudgetUs = 2000,
+        .damageDebug = ACNCAGE_DAMAGE_DEBUG_OFF,
+    };
+
+    // Backend & rendering
+    static const char* const backendChoices[] = {
+        [ACNCAGE_BACKEND_AUTO] = "auto",
+        [ACNCAGE_BACKEND_DRM] = "drm",
+        [ACNCAGE_BACKEND_HEADLESS] = "headless",
+        [ACNCAGE_BACKEND_WAYLAND] = "wayland",
+        [ACNCAGE_BACKEND_X11] = "x11",
+    };
+    int backend = config->backend;
+    if (Read_Choice("ACNCAGE_BACKEND", backendChoices, 5, &backend) != 0) return -1;
+    config->backend = backend;
+    if (Read_String("ACNCAGE_DRM_DEVICE", &config->drmDevice) != 0) return -1;
+    static const char* const rendererChoices[] = {
+        [ACNCAGE_RENDERER_AUTO] = "auto",
+        [ACNCAGE_RENDERER_GLES2] = "gles2",
+        [ACNCAGE_RENDERER_PIXMAN] = "pixman",
+        [ACNCAGE_RENDERER_VULKAN] = "vulkan",
+    };
+    int renderer = config->renderer;
+    if (Read_Choice("ACNCAGE_RENDERER", rendererChoices, 4, &renderer) != 0)
+        return -1;
+    config->renderer = renderer;
+
+    // Frame scheduling
+    if (Read_Bool("ACNCAGE_RENDER_DELAY", &config->renderDelay) != 0) return -1;
+    if (Read_Int("ACNCAGE_MAX_RENDER_TIME", 0, 1000, &config->maxRenderTimeMs) != 0)
+        return -1;
+
+    // Fullscreen views
+    if (Read_Bool("ACNCAGE_DIRECT_SCANOUT", &config->directScanout) != 0) return -1;
+
+    // X11 clients
+    if (Read_Bool("ACNCAGE_XWAYLAND", &config->xwayland) != 0) return -1;
+
+    // Outputs
+    if (Read_Bool("ACNCAGE_MIRROR", &config->mirror) != 0) return -1;
+    if (Read_Float("ACNCAGE_SCALE", 0.25f, 8.0f, &config->scale) != 0) return -1;
+
+    // Screen capture
+    static const char* const screencopyChoices[] = {
+        [ACNCAGE_SCREENCOPY_OFF] = "off",
+        [ACNCAGE_SCREENCOPY_ON] = "on",
+    };
+    int screencopy = config->screencopy;
+    if (Read_Choice("ACNCAGE_SCREENCOPY", screencopyChoices, 2, &screencopy) != 0)
+        return -1;
+    config->screencopy = screencopy;
+
+    // Hidden views
+    static const char* const hiddenFramesChoices[] = {
+        [ACNCAGE_HIDDEN_FRAMES_NONE] = "none",
+        [ACNCAGE_HIDDEN_FRAMES_THROTTLE] = "throttle",
+        [ACNCAGE_HIDDEN_FRAMES_NORMAL] = "normal",
+    };
+    int hiddenFrames = config->hiddenFrames;
+    if (Read_Choice("ACNCAGE_HIDDEN_FRAMES", hiddenFramesChoices, 3,
+                    &hiddenFrames) != 0)
+        return -1;
+    config->hiddenFrames = hiddenFrames;
+    if (Read_Int("ACNCAGE_HIDDEN_FRAME_INTERVAL", 1, 60000,
+                 &config->hiddenFrameIntervalMs) != 0)
+        return -1;
+
+    // Clients committing faster than outputs can show
+    if (Read_Int("ACNCAGE_COMMIT_RATE_LIMIT", 0, 100, &config->commitRateLimit) != 0)
+        return -1;
+    if (Read_Int("ACNCAGE_COMMIT_THROTTLE_INTERVAL", 1, 60000,
+                 &config->commitThrottleIntervalMs) != 0)
+        return -1;
+
+    // Output modes
+    static const char* const modePolicyChoices[] = {
+        [ACNCAGE_MODE_POLICY_PREFERRED] = "preferred",
+        [ACNCAGE_MODE_POLICY_MAX_REFRESH] = "max-refresh",
+        [ACNCAGE_MODE_POLICY_EXACT] = "exact",
+        [ACNCAGE_MODE_POLICY_CUSTOM] = "custom",
+    };
+    int modePolicy = config->modePolicy;
+    if (Read_Choice("ACNCAGE_MODE_POLICY", modePolicyChoices, 4, &modePolicy) != 0)
+        return -1;
+    config->modePolicy = modePolicy;
+    if (Read_Mode("ACNCAGE_MODE", &config->mode) != 0) return -1;
+    if (Read_Mode("ACNCAGE_MAX_MODE", &config->maxMode) != 0) return -1;
+    if ((config->modePolicy == ACNCAGE_MODE_POLICY_EXACT ||
+         config->modePolicy == ACNCAGE_MODE_POLICY_CUSTOM) &&
+        config->mode.width == 0) {
+        wlr_log(WLR_ERROR, "ACNCAGE_MODE is required by the %s mode policy",
+                modePolicyChoices[config->modePolicy]);
+        return -1;
+    }
+
+    // Refresh rate
+    static const char* const adaptiveSyncChoices[] = {
+        [ACNCAGE_ADAPTIVE_SYNC_OFF] = "off",
+        [ACNCAGE_ADAPTIVE_SYNC_ON] = "on",
+        [ACNCAGE_ADAPTIVE_SYNC_CONTENT] = "content",
+    };
+    int adaptiveSync = config->adaptiveSync;
+    if (Read_Choice("ACNCAGE_ADAPTIVE_SYNC", adaptiveSyncChoices, 3,
+                    &adaptiveSync) != 0)
+        return -1;
+    config->adaptiveSync = adaptiveSync;
+    if (Read_Int("ACNCAGE_STATIC_REFRESH", 0, 1000, &config->staticRefreshHz) != 0)
+        return -1;
+
+    // Keyboards
+    if (Read_String("ACNCAGE_KEYMAP_CACHE", &config->keymapCacheDir) != 0) return -1;
+
+    // Pointers
+    static const char* const coalescingChoices[] = {
+        [ACNCAGE_POINTER_COALESCING_NONE] = "none",
+        [ACNCAGE_POINTER_COALESCING_FRAME] = "frame",
+        [ACNCAGE_POINTER_COALESCING_OUTPUT] = "output",
+    };
+    int coalescing = config->pointerCoalescing;
+    if (Read_Choice("ACNCAGE_POINTER_COALESCING", coalescingChoices, 3,
+                    &coalescing) != 0)
+        return -1;
+    config->pointerCoalescing = coalescing;
+
+    // Memory
+    if (Read_Int("ACNCAGE_SLAB_PREWARM", 0, 4096, &config->slabPrewarm) != 0)
+        return -1;
+
+    // Low-latency profile
+    static const char* const schedChoices[] = {
+        [ACNCAGE_SCHED_OTHER] = "other",
+        [ACNCAGE_SCHED_FIFO] = "fifo",
+        [ACNCAGE_SCHED_RR] = "rr",
+    };
+    int schedPolicy = config->schedPolicy;
+    if (Read_Choice("ACNCAGE_SCHED", schedChoices, 3, &schedPolicy) != 0) return -1;
+    config->schedPolicy = schedPolicy;
+    if (Read_Int("ACNCAGE_SCHED_PRIORITY", 1, 99, &config->schedPriority) != 0)
+        return -1;
+    if (Read_String("ACNCAGE_CPU_AFFINITY", &config->cpuAffinity) != 0) return -1;
+    if (Read_Bool("ACNCAGE_MLOCK", &config->memoryLock) != 0) return -1;
+    // Note: Capped well below the usual 8 MiB stack limit
+    if (Read_Int("ACNCAGE_STACK_PREFAULT", 0, 4096, &config->stackPrefaultKiB) != 0)
+        return -1;
+
+    // Diagnostics
+    if (Read_String("ACNCAGE_TRACE", &config->tracePath) != 0) return -1;
+    if (Read_Bool("ACNCAGE_DISPATCH_TIMING", &config->dispatchTiming) != 0)
+        return -1;
+    if (Read_Int("ACNCAGE_DISPATCH_BUDGET", 0, 1000000,
+                 &config->dispatchBudgetUs) != 0)
+        return -1;
+    static const char* const damageDebugChoices[] = {
+        [ACNCAGE_DAMAGE_DEBUG_OFF] = "off",
+        [ACNCAGE_DAMAGE_DEBUG_RERENDER] = "rerender",
+        [ACNCAGE_DAMAGE_DEBUG_HIGHLIGHT] = "highlight",
+    };
+    int damageDebug = config->damageDebug;
+    if (Read_Choice("ACNCAGE_DAMAGE_DEBUG", damageDebugChoices, 3,
+                    &damageDebug) != 0)
+        return -1;
+    config->damageDebug = damageDebug;
+
+    return 0;
+}
+
+static int Read_Bool(const char* name, bool* value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    if (strcmp(env, "1") == 0 || strcmp(env, "true") == 0 ||
+        strcmp(env, "on") == 0) {
+        *value = true;
+        return 0;
+    }
+    if (strcmp(env, "0") == 0 || strcmp(env, "false") == 0 ||
+        strcmp(env, "off") == 0) {
+        *value = false;
+        return 0;
+    }
+
+    wlr_log(WLR_ERROR, "Invalid boolean for %s: %s", name, env);
+    return -1;
+}
+
+static int Read_Int(const char* name, int min, int max, int* value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    char* end = NULL;
+    errno = 0;
+    long parsed = strtol(env, &end, 10);
+    if (errno != 0 || end == env || *end != '\0' || parsed < min || parsed > max) {
+        wlr_log(WLR_ERROR, "Invalid integer for %s: %s (expected %d..%d)", name, env,
+                min, max);
+        return -1;
+    }
+
+    *value = (int)parsed;
+    return 0;
+}
+
+static int Read_Float(const char* name, float min, float max, float* value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    char* end = NULL;
+    errno = 0;
+    float parsed = strtof(env, &end);
+    bool inRange = parsed >= min && parsed <= max;  // NaN never is
+    if (errno != 0 || end == env || *end != '\0' || !inRange) {
+        wlr_log(WLR_ERROR, "Invalid number for %s: %s (expected %g..%g)", name, env,
+                min, max);
+        return -1;
+    }
+
+    *value = parsed;
+    return 0;
+}
+
+static int Read_String(const char* name, const char** value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    if (env[0] == '\0') {
+        wlr_log(WLR_ERROR, "Empty value for %s", name);
+        return -1;
+    }
+
+    *value = env;
+    return 0;
+}
+
+static int Read_Choice(const char* name,
+                       const char* const choices[],
+                       int count,
+                       int* value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(env, choices[i]) == 0) {
+            *value = i;
+            return 0;
+        }
+    }
+
+    wlr_log(WLR_ERROR, "Invalid value for %s: %s", name, env);
+    return -1;
+}
+
+// Parses WxH, or WxH@Hz (fractional Hz allowed, e.g. 59.94)
+static int Read_Mode(const char* name, struct ACNCageModeSpec* value) {
+    const char* env = getenv(name);
+    if (env == NULL) return 0;
+
+    int width = 0, height = 0, consumed = 0, refreshConsumed = 0;
+    double refreshHz = 0;
+    bool valid = sscanf(env, "%dx%d%n", &width, &height, &consumed) == 2;
+    if (valid && env[consumed] == '@') {
+        const char* refresh = env + consumed + 1;
+        valid = sscanf(refresh, "%lf%n", &refreshHz, &refreshConsumed) == 1;
+        consumed += 1 + refreshConsumed;
+    }
+    if (!valid || env[consumed] != '\0' || width <= 0 || height <= 0 ||
+        refreshHz < 0 || refreshHz > 1000) {
+        wlr_log(WLR_ERROR, "Invalid mode for %s: %s (expected WxH or WxH@Hz)", name,
+                env);
+        return -1;
+    }
+
+    *value = (struct ACNCageModeSpec){
+        .width = width,
+        .height = height,
+        .refreshMhz = (int)(refreshHz * 1000 + 0.5),
+    };
+    return 0;
+}
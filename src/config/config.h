@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+
+enum ACNCageBackend {
+    ACNCAGE_BACKEND_AUTO,      // Probed by wlroots (WLR_BACKENDS)
+    ACNCAGE_BACKEND_DRM,       // DRM/KMS & libinput, through a session
+    ACNCAGE_BACKEND_HEADLESS,  // Virtual output, no input
+    ACNCAGE_BACKEND_WAYLAND,   // Window of a parent Wayland compositor
+    ACNCAGE_BACKEND_X11,       // Window of a parent X11 server
+};
+
+enum ACNCageRenderer {
+    ACNCAGE_RENDERER_AUTO,    // Picked by wlroots (WLR_RENDERER)
+    ACNCAGE_RENDERER_GLES2,   // OpenGL ES 2, on the backend's DRM device
+    ACNCAGE_RENDERER_PIXMAN,  // Software
+    ACNCAGE_RENDERER_VULKAN,  // Vulkan, on the backend's DRM device
+};
+
+enum ACNCagePointerCoalescing {
+    ACNCAGE_POINTER_COALESCING_NONE,    // Process every motion event
+    ACNCAGE_POINTER_COALESCING_FRAME,   // Once per pointer frame
+    ACNCAGE_POINTER_COALESCING_OUTPUT,  // Once per output frame
+};
+
+enum ACNCageModePolicy {
+    ACNCAGE_MODE_POLICY_PREFERRED,    // Mode advertised as preferred
+    ACNCAGE_MODE_POLICY_MAX_REFRESH,  // Highest refresh, then largest resolution
+    ACNCAGE_MODE_POLICY_EXACT,        // Advertised mode matching ACNCAGE_MODE
+    ACNCAGE_MODE_POLICY_CUSTOM,       // ACNCAGE_MODE, even if not advertised
+};
+
+// Output mode, 0 fields match any
+struct ACNCageModeSpec {
+    int width;
+    int height;
+    int refreshMhz;
+};
+
+enum ACNCageAdaptiveSync {
+    ACNCAGE_ADAPTIVE_SYNC_OFF,      // Fixed refresh
+    ACNCAGE_ADAPTIVE_SYNC_ON,       // VRR whenever the output supports it
+    ACNCAGE_ADAPTIVE_SYNC_CONTENT,  // Follow the fullscreen view's content type
+};
+
+enum ACNCageHiddenFrames {
+    ACNCAGE_HIDDEN_FRAMES_NONE,      // No frame callbacks until shown again
+    ACNCAGE_HIDDEN_FRAMES_THROTTLE,  // One frame callback per interval
+    ACNCAGE_HIDDEN_FRAMES_NORMAL,    // Frame callbacks at the output's rate
+};
+
+enum ACNCageScreencopy {
+    ACNCAGE_SCREENCOPY_OFF,  // No capture protocol
+    ACNCAGE_SCREENCOPY_ON,   // wlr-screencopy, damage-tracked
+};
+
+enum ACNCageSchedPolicy {
+    ACNCAGE_SCHED_OTHER,  // Default time-sharing scheduling
+    ACNCAGE_SCHED_FIFO,   // SCHED_FIFO, runs until it blocks
+    ACNCAGE_SCHED_RR,     // SCHED_RR, round-robin among equal priorities
+};
+
+enum ACNCageDamageDebug {
+    ACNCAGE_DAMAGE_DEBUG_OFF,        // Render normally
+    ACNCAGE_DAMAGE_DEBUG_RERENDER,   // Redraw the whole output every frame
+    ACNCAGE_DAMAGE_DEBUG_HIGHLIGHT,  // Tint recently damaged regions
+};
+
+struct ACNCageConfig {
+    // Backend & rendering, probed by wlroots unless named
+    enum ACNCageBackend backend;
+    const char* drmDevice;  // GPU (e.g. /dev/dri/card0), NULL to find one
+    enum ACNCageRenderer renderer;
+
+    // Frame scheduling
+    bool renderDelay;     // Delay rendering toward the next vblank
+    int maxRenderTimeMs;  // Render budget in ms, 0 to predict it from past frames
+
+    // Fullscreen views
+    bool directScanout;  // Scan fullscreen client buffers out, skipping composition
+
+    // X11 clients
+    bool xwayland;  // Xwayland, started on the first X11 connection
+
+    // Outputs
+    bool mirror;  // First output composited, the others show copies of it
+    float scale;  // Scale of every output (e.g. 1.5), sent to clients as preferred
+
+    // Screen capture
+    enum ACNCageScreencopy screencopy;
+
+    // Hidden views (covered, or beneath a fullscreen view)
+    enum ACNCageHiddenFrames hiddenFrames;  // Frame callback policy
+    int hiddenFrameIntervalMs;              // Frame callback interval (throttle)
+
+    // Clients committing faster than outputs can show
+    int commitRateLimit;           // Times the fastest refresh rate, 0 if unlimited
+    int commitThrottleIntervalMs;  // Frame callback interval, while over the limit
+
+    // Output modes
+    enum ACNCageModePolicy modePolicy;
+    struct ACNCageModeSpec mode;     // Exact or custom mode
+    struct ACNCageModeSpec maxMode;  // Cap on the selected mode
+
+    // Refresh rate
+    enum ACNCageAdaptiveSync adaptiveSync;
+    int staticRefreshHz;  // Static content refresh (content policy), 0 to keep it
+
+    // Keyboards
+    const char* keymapCacheDir;  // Serialized keymaps directory, NULL if disabled
+
+    // Pointers
+    enum ACNCagePointerCoalescing pointerCoalescing;  // Focus & hit-test rate
+
+    // Memory
+    int slabPrewarm;  // Objects preallocated per type (views, popups, ...)
+
+    // Low-latency profile
+    enum ACNCageSchedPolicy schedPolicy;
+    int schedPriority;        // Realtime priority (FIFO & RR)
+    const char* cpuAffinity;  // CPU list (e.g. 0,2-3), NULL to keep it
+    bool memoryLock;          // mlockall, so that nothing ever pages out
+    int stackPrefaultKiB;     // Stack touched upfront, 0 if disabled
+
+    // Diagnostics
+    const char* tracePath;  // Startup trace-event JSON file, NULL if disabled
+    bool dispatchTiming;    // Time every listener's handler
+    int dispatchBudgetUs;   // Handlers running longer are logged, 0 to never log
+    enum ACNCageDamageDebug damageDebug;
+};
+
+/**
+ * Load the configuration from the environment (ACNCAGE_*), on top of defaults
+ * :param config: config to load
+ * :return: Success 0, Error -1
+ */
+int ACNCageConfig_load(struct ACNCageConfig* config);
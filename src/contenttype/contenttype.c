@@ -0,0 +1,212 @@
+#include "contenttype.h"
+
+#include <stdlib.h>  // calloc, free
+
+#include <wlr/util/addon.h>  // wlr_addon
+#include <wlr/util/log.h>    // wlr_log
+
+#include "content-type-v1-protocol.h"  // wp_content_type_*_v1
+#include "dispatch.h"                  // ACNCAGE_DISPATCH
+
+#define CONTENT_TYPE_MANAGER_VERSION 1
+
+// Content type object of a surface, double-buffered like the surface state
+struct ACNCageContentTypeSurface {
+    struct wl_resource* resource;  // NULL once destroyed by the client
+    struct wlr_surface* surface;
+    struct ACNCageContentTypeManager* manager;
+    struct wlr_addon addon;  // Attached to the surface, owned by the manager
+
+    enum ACNCageContentType pending;
+    enum ACNCageContentType current;
+
+    // Listeners
+    struct wl_listener surfaceCommitListener;
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Destroy_ContentTypeSurface(
+    struct ACNCageContentTypeSurface* typeSurface);
+
+/** wp_content_type_manager_v1 **/
+static void Manager_GetSurfaceContentType(struct wl_client* client,
+                                          struct wl_resource* resource, uint32_t id,
+                                          struct wl_resource* surfaceResource);
+
+/** wp_content_type_v1 **/
+static void ContentType_SetContentType(struct wl_client* client,
+                                       struct wl_resource* resource,
+                                       uint32_t contentType);
+static void ContentType_ResourceDestroy(struct wl_resource* resource);
+
+/** Surface addon **/
+static void Addon_Destroy(struct wlr_addon* addon);
+
+/** Commit surface **/
+static void Surface_Commit(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Surface_Commit)
+
+static const struct wp_content_type_manager_v1_interface managerImpl = {
+    .destroy = ACNCageGlobal_DestroyResource,
+    .get_surface_content_type = Manager_GetSurfaceContentType,
+};
+
+static const struct wp_content_type_v1_interface contentTypeImpl = {
+    .destroy = ACNCageGlobal_DestroyResource,
+    .set_content_type = ContentType_SetContentType,
+};
+
+static const struct wlr_addon_interface addonImpl = {
+    .name = "acncage_content_type_surface",
+    .destroy = Addon_Destroy,
+};
+
+struct ACNCageContentTypeManager* ACNCageContentTypeManager_create(
+    struct wl_display* wl_display) {
+    struct ACNCageContentTypeManager* manager =
+        calloc(1, sizeof(struct ACNCageContentTypeManager));
+    if (manager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageContentTypeManager");
+        return NULL;
+    }
+
+    if (ACNCageGlobal_init(&manager->global, wl_display,
+                           &wp_content_type_manager_v1_interface,
+                           CONTENT_TYPE_MANAGER_VERSION,
+                           &managerImpl, manager) != 0) {
+        free(manager);
+        return NULL;
+    }
+
+    wl_signal_init(&manager->events.change);
+
+    return manager;
+}
+
+enum ACNCageContentType ACNCageContentType_get(
+    struct ACNCageContentTypeManager* manager, struct wlr_surface* surface) {
+    if (manager == NULL || surface == NULL) return ACNCAGE_CONTENT_TYPE_NONE;
+
+    struct wlr_addon* addon = wlr_addon_find(&surface->addons, manager, &addonImpl);
+    if (addon == NULL) return ACNCAGE_CONTENT_TYPE_NONE;
+
+    struct ACNCageContentTypeSurface* typeSurface =
+        wl_container_of(addon, typeSurface, addon);
+    return typeSurface->current;
+}
+
+static void Destroy_ContentTypeSurface(
+    struct ACNCageContentTypeSurface* typeSurface) {
+    if (typeSurface->resource != NULL)
+        wl_resource_set_user_data(typeSurface->resource, NULL);
+
+    wlr_addon_finish(&typeSurface->addon);
+    wl_list_remove(&typeSurface->surfaceCommitListener.link);
+    free(typeSurface);
+}
+
+static void Manager_GetSurfaceContentType(struct wl_client* client,
+                                          struct wl_resource* resource, uint32_t id,
+                                          struct wl_resource* surfaceResource) {
+    struct ACNCageContentTypeManager* manager = wl_resource_get_user_data(resource);
+    struct wlr_surface* surface = wlr_surface_from_resource(surfaceResource);
+
+    // One content type object per surface
+    // Note: A destroyed one may linger until the commit resetting its type, the
+    // new object then takes it over
+    struct ACNCageContentTypeSurface* typeSurface = NULL;
+    struct wlr_addon* addon = wlr_addon_find(&surface->addons, manager, &addonImpl);
+    if (addon != NULL) {
+        typeSurface = wl_container_of(addon, typeSurface, addon);
+        if (typeSurface->resource != NULL) {
+            wl_resource_post_error(
+                resource, WP_CONTENT_TYPE_MANAGER_V1_ERROR_ALREADY_CONSTRUCTED,
+                "wp_content_type_v1 already constructed");
+            return;
+        }
+    }
+
+    struct wl_resource* typeResource =
+        wl_resource_create(client, &wp_content_type_v1_interface,
+                           wl_resource_get_version(resource), id);
+    if (typeResource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    if (typeSurface == NULL) {
+        typeSurface = calloc(1, sizeof(struct ACNCageContentTypeSurface));
+        if (typeSurface == NULL) {
+            wl_resource_destroy(typeResource);
+            wl_client_post_no_memory(client);
+            return;
+        }
+
+        typeSurface->surface = surface;
+        typeSurface->manager = manager;
+        wlr_addon_init(&typeSurface->addon, &surface->addons, manager, &addonImpl);
+
+        typeSurface->surfaceCommitListener.notify = ACNCAGE_DISPATCH(Surface_Commit);
+        wl_signal_add(&surface->events.commit, &typeSurface->surfaceCommitListener);
+    }
+
+    typeSurface->resource = typeResource;
+    wl_resource_set_implementation(typeResource, &contentTypeImpl, typeSurface,
+                                   ContentType_ResourceDestroy);
+}
+
+static void ContentType_SetContentType(struct wl_client* client
+                                       __attribute__((unused)),
+                                       struct wl_resource* resource,
+                                       uint32_t contentType) {
+    struct ACNCageContentTypeSurface* typeSurface =
+        wl_resource_get_user_data(resource);
+    if (typeSurface == NULL) return;  // Surface destroyed, object is inert
+
+    // wp_content_type_v1 defines no error, values from newer versions are ignored
+    if (contentType > WP_CONTENT_TYPE_V1_TYPE_GAME) {
+        wlr_log(WLR_DEBUG, "Ignoring unknown content type %u", contentType);
+        return;
+    }
+
+    // wp_content_type_v1.type values match ACNCageContentType
+    typeSurface->pending = contentType;
+}
+
+// Destroying the object resets the content type, on the next surface commit
+static void ContentType_ResourceDestroy(struct wl_resource* resource) {
+    struct ACNCageContentTypeSurface* typeSurface =
+        wl_resource_get_user_data(resource);
+    if (typeSurface == NULL) return;
+
+    typeSurface->resource = NULL;
+    typeSurface->pending = ACNCAGE_CONTENT_TYPE_NONE;
+    if (typeSurface->current == ACNCAGE_CONTENT_TYPE_NONE)
+        Destroy_ContentTypeSurface(typeSurface);
+}
+
+// Raise by the surface, when it goes away before its content type object
+static void Addon_Destroy(struct wlr_addon* addon) {
+    struct ACNCageContentTypeSurface* typeSurface =
+        wl_container_of(addon, typeSurface, addon);
+    Destroy_ContentTypeSurface(typeSurface);
+}
+
+// Raise by the surface, when the client commits a new surface state
+static void Surface_Commit(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageContentTypeSurface* typeSurface =
+        wl_container_of(listener, typeSurface, surfaceCommitListener);
+    if (typeSurface->pending == typeSurface->current) return;
+
+    typeSurface->current = typeSurface->pending;
+    wl_signal_emit(&typeSurface->manager->events.change, typeSurface->surface);
+
+    // Reset to none by destroying the object, nothing left to track
+    if (typeSurface->resource == NULL) Destroy_ContentTypeSurface(typeSurface);
+}
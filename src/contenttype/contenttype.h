@@ -0,0 +1,40 @@
+#pragma once
+
+#include <wayland-server-core.h>         // wl_signal
+#include <wlr/types/wlr_compositor.h>  // wlr_surface
+
+#include "global.h"  // ACNCageGlobal
+
+// Mirrors wp_content_type_v1.type
+enum ACNCageContentType {
+    ACNCAGE_CONTENT_TYPE_NONE,
+    ACNCAGE_CONTENT_TYPE_PHOTO,
+    ACNCAGE_CONTENT_TYPE_VIDEO,
+    ACNCAGE_CONTENT_TYPE_GAME,
+};
+
+// wp_content_type_manager_v1 global (content-type-v1, staging)
+struct ACNCageContentTypeManager {
+    struct ACNCageGlobal global;
+
+    struct {
+        struct wl_signal change;  // wlr_surface, w. a newly committed content type
+    } events;
+};
+
+/**
+ * Create the wp_content_type_manager_v1 global
+ * :param wl_display: display advertising the global
+ * :return: Success the manager, Error NULL
+ */
+struct ACNCageContentTypeManager* ACNCageContentTypeManager_create(
+    struct wl_display* wl_display);
+
+/**
+ * Get the committed content type of the provided surface
+ * :param manager: manager the content type was set through
+ * :param surface: surface to look up
+ * :return: Content type, ACNCAGE_CONTENT_TYPE_NONE if never set
+ */
+enum ACNCageContentType ACNCageContentType_get(
+    struct ACNCageContentTypeManager* manager, struct wlr_surface* surface);
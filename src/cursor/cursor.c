@@ -1 +1,57 @@
 #include "cursor.h"
+
+#include <string.h>  // strcmp
+
+#include <wlr/types/wlr_cursor.h>            // wlr_cursor
+#include <wlr/types/wlr_xcursor_manager.h>  // wlr_xcursor_manager
+#include <wlr/util/log.h>                    // wlr_log
+
+#include "output.h"  // ACNCageOutput
+#include "server.h"  // ACNCageServer
+#include "trace.h"   // ACNCageTrace_begin, ACNCageTrace_end
+
+int ACNCageServer_LoadCursorTheme(struct ACNCageServer* server) {
+    // Nothing to point with, the theme isn't needed (yet)
+    if (!server->cursorThemeWanted) return 0;
+
+    struct wlr_xcursor_manager* manager = server->xcursor_manager;
+    int loadedScales = wl_list_length(&manager->scaled_themes);
+    ACNCageTrace_begin(&server->trace, "ACNCageServer_LoadCursorTheme");
+
+    // One theme per output scale, scales already loaded are kept as is
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) {
+        if (!wlr_xcursor_manager_load(manager, output->wlr_output->scale)) {
+            wlr_log(WLR_ERROR, "Failed to load xcursor theme at scale %.2f",
+                    output->wlr_output->scale);
+            ACNCageTrace_end(&server->trace, "ACNCageServer_LoadCursorTheme");
+            return -1;
+        }
+    }
+    if (wl_list_empty(&server->outputs) && !wlr_xcursor_manager_load(manager, 1)) {
+        wlr_log(WLR_ERROR, "Failed to load xcursor theme");
+        ACNCageTrace_end(&server->trace, "ACNCageServer_LoadCursorTheme");
+        return -1;
+    }
+    ACNCageTrace_end(&server->trace, "ACNCageServer_LoadCursorTheme");
+
+    if (wl_list_length(&manager->scaled_themes) == loadedScales) return 0;
+    wlr_log(WLR_DEBUG, "Loaded xcursor theme, %d scale(s)",
+            wl_list_length(&manager->scaled_themes));
+
+    // Newly loaded scales need the current image as well
+    if (server->cursorImage != NULL)
+        wlr_xcursor_manager_set_cursor_image(manager, server->cursorImage,
+                                             server->cursor);
+    return 0;
+}
+
+void ACNCageServer_SetCursorImage(struct ACNCageServer* server, const char* name) {
+    // Already showing it
+    if (server->cursorImage != NULL && strcmp(server->cursorImage, name) == 0)
+        return;
+
+    server->cursorImage = name;
+    wlr_xcursor_manager_set_cursor_image(server->xcursor_manager, name,
+                                         server->cursor);
+}
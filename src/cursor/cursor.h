@@ -1,8 +1,38 @@
 #pragma once
 
+struct ACNCageServer;
+
 /**
  * Create listeners for cursor events
  * :param server: server hosting the listeners
  * :return: Success 0, Error -1
  */
 int ACNCageServer_CreateCursorListeners(struct ACNCageServer* server);
+
+/**
+ * Load the xcursor theme at every output scale, once a pointer device exists
+ * Note: Touch-only setups never read the theme from disk
+ * :param server: server hosting the cursor
+ * :return: Success 0, Error -1
+ */
+int ACNCageServer_LoadCursorTheme(struct ACNCageServer* server);
+
+/**
+ * Show the named xcursor image, unless it's shown already
+ * Note: Whatever else sets the cursor image must reset server->cursorImage
+ * :param server: server hosting the cursor
+ * :param   name: xcursor image name, must outlive its use (e.g. a literal)
+ */
+void ACNCageServer_SetCursorImage(struct ACNCageServer* server, const char* name);
+
+/**
+ * Process the coalesced pointer motion, if any, then end the pointer frame
+ * :param server: server hosting the cursor
+ */
+void ACNCageServer_FlushCursorMotion(struct ACNCageServer* server);
+
+/**
+ * Log the cursor hit-test cache statistics
+ * :param server: server hosting the cursor
+ */
+void ACNCageServer_LogCursorStats(struct ACNCageServer* server);
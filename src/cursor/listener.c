@@ -1,9 +1,18 @@
 #include "cursor.h"
 
-#include <wlr/util/log.h>  // wlr_log
+#include <inttypes.h>  // PRIu64
 
-#include "server.h"  // ACNCageServer
-#include "view.h"    // ACNCageView_focus
+#include <wlr/types/wlr_cursor.h>            // wlr_cursor
+#include <wlr/types/wlr_output_layout.h>     // wlr_output_layout_output_at
+#include <wlr/types/wlr_seat.h>              // wlr_seat
+#include <wlr/types/wlr_xcursor_manager.h>  // wlr_xcursor_manager
+#include <wlr/util/box.h>                    // wlr_box_contains_point
+#include <wlr/util/log.h>                    // wlr_log
+
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+#include "latency.h"   // ACNCageLatency_StampInput
+#include "server.h"    // ACNCageServer
+#include "view.h"      // ACNCageView_focus
 
 /***** Static function declarations *****/
 
@@ -14,7 +23,14 @@ static struct ACNCageView* Identify_Accessed_View(struct ACNCageServer* server,
                                                   struct wlr_surface** surface,
                                                   double* surfaceLocalX,
                                                   double* surfaceLocalY);
+static void Cache_Accessed_Surface(struct ACNCageServer* server,
+                                   struct wlr_scene_node* scene_node,
+                                   struct wlr_surface* surface,
+                                   struct ACNCageView* view);
+static void Clear_Accessed_Surface(struct ACNCageServer* server);
 static void Process_Cursor_Motion(struct ACNCageServer* server, uint32_t time_msec);
+static void Queue_Cursor_Motion(struct ACNCageServer* server, uint32_t time_msec);
+static void Process_Queued_Cursor_Motion(struct ACNCageServer* server);
 
 /** Cursor motion event **/
 static int Create_CursorMotion_Listener(struct ACNCageServer* server);
@@ -36,9 +52,24 @@ static void Cursor_Axis(struct wl_listener* listener, void* data);
 static int Create_CursorFrame_Listener(struct ACNCageServer* server);
 static void Cursor_Frame(struct wl_listener* listener, void* data);
 
+/** Destroy cached surface **/
+static void HitCache_SurfaceDestroy(struct wl_listener* listener, void* data);
+
 /****************************************/
 
+ACNCAGE_DISPATCH_DEFINE(HitCache_SurfaceDestroy)
+ACNCAGE_DISPATCH_DEFINE(Cursor_Motion)
+ACNCAGE_DISPATCH_DEFINE(Cursor_MotionAbsolute)
+ACNCAGE_DISPATCH_DEFINE(Cursor_Button)
+ACNCAGE_DISPATCH_DEFINE(Cursor_Axis)
+ACNCAGE_DISPATCH_DEFINE(Cursor_Frame)
+
 int ACNCageServer_CreateCursorListeners(struct ACNCageServer* server) {
+    // Hit-test cache starts out empty
+    server->hitCache.surfaceDestroyListener.notify =
+        ACNCAGE_DISPATCH(HitCache_SurfaceDestroy);
+    wl_list_init(&server->hitCache.surfaceDestroyListener.link);
+
     // Cursor motion event listener
     if (Create_CursorMotion_Listener(server) != 0) return -1;
 
@@ -63,6 +94,24 @@ static struct ACNCageView* Identify_Accessed_View(struct ACNCageServer* server,
                                                   struct wlr_surface** surface,
                                                   double* surfaceLocalX,
                                                   double* surfaceLocalY) {
+    struct ACNCageHitCache* cache = &server->hitCache;
+
+    // Still within the surface found last time, & nothing has moved since
+    if (cache->surface != NULL && cache->generation == server->sceneGeneration &&
+        wlr_box_contains_point(&cache->box, layoutLocalX, layoutLocalY)) {
+        double cachedX = layoutLocalX - cache->box.x;
+        double cachedY = layoutLocalY - cache->box.y;
+        if (wlr_surface_point_accepts_input(cache->surface, cachedX, cachedY)) {
+            cache->hits++;
+            *surface = cache->surface;
+            *surfaceLocalX = cachedX;
+            *surfaceLocalY = cachedY;
+            return cache->view;
+        }
+    }
+    cache->misses++;
+    Clear_Accessed_Surface(server);
+
     // Identify the topmost scene node, containing the layout local coordinate
     struct wlr_scene_node* scene_node =
         wlr_scene_node_at(&server->scene->tree.node, layoutLocalX, layoutLocalY,
@@ -81,9 +130,66 @@ static struct ACNCageView* Identify_Accessed_View(struct ACNCageServer* server,
         scene_tree = scene_tree->node.parent;
         if (scene_tree == NULL) return NULL;
     }
+
+    Cache_Accessed_Surface(server, scene_node, *surface, scene_tree->node.data);
     return scene_tree->node.data;
 }
 
+static void Cache_Accessed_Surface(struct ACNCageServer* server,
+                                   struct wlr_scene_node* scene_node,
+                                   struct wlr_surface* surface,
+                                   struct ACNCageView* view) {
+    struct ACNCageHitCache* cache = &server->hitCache;
+
+    // Only the view's topmost node, as the box is then sure not to be covered by
+    // a subsurface or popup of the view
+    for (struct wlr_scene_node* node = scene_node;
+         node != &view->wlr_scene_tree->node; node = &node->parent->node) {
+        if (node->parent == NULL || node->link.next != &node->parent->children)
+            return;
+    }
+
+    int x, y;
+    if (!wlr_scene_node_coords(scene_node, &x, &y)) return;
+
+    cache->generation = server->sceneGeneration;
+    cache->surface = surface;
+    cache->view = view;
+    cache->box = (struct wlr_box){.x = x,
+                                  .y = y,
+                                  .width = surface->current.width,
+                                  .height = surface->current.height};
+    wl_signal_add(&surface->events.destroy, &cache->surfaceDestroyListener);
+}
+
+static void Clear_Accessed_Surface(struct ACNCageServer* server) {
+    struct ACNCageHitCache* cache = &server->hitCache;
+    if (cache->surface == NULL) return;
+
+    cache->surface = NULL;
+    cache->view = NULL;
+    wl_list_remove(&cache->surfaceDestroyListener.link);
+    wl_list_init(&cache->surfaceDestroyListener.link);
+}
+
+// Raise by the cached surface, before it goes away
+static void HitCache_SurfaceDestroy(struct wl_listener* listener,
+                                    void* data __attribute__((unused))) {
+    struct ACNCageServer* server =
+        wl_container_of(listener, server, hitCache.surfaceDestroyListener);
+    Clear_Accessed_Surface(server);
+}
+
+void ACNCageServer_LogCursorStats(struct ACNCageServer* server) {
+    struct ACNCageHitCache* cache = &server->hitCache;
+    uint64_t lookups = cache->hits + cache->misses;
+    if (lookups == 0) return;
+
+    wlr_log(WLR_INFO, "Cursor hit-test cache: %" PRIu64 " hits, %" PRIu64
+            " misses (%.1f%% hit rate)", cache->hits, cache->misses,
+            100.0 * cache->hits / lookups);
+}
+
 static void Process_Cursor_Motion(struct ACNCageServer* server, uint32_t time_msec) {
     struct wlr_surface* surface = NULL;
     double surfaceLocalX, surfaceLocalY;
@@ -92,9 +198,7 @@ static void Process_Cursor_Motion(struct ACNCageServer* server, uint32_t time_ms
                                &surface, &surfaceLocalX, &surfaceLocalY);
 
     // No view accessed, reset cursor image to default
-    if (view == NULL)
-        wlr_xcursor_manager_set_cursor_image(server->xcursor_manager, "left_ptr",
-                                             server->cursor);
+    if (view == NULL) ACNCageServer_SetCursorImage(server, "left_ptr");
 
     if (surface == NULL) {
         // Clear pointer focus
@@ -110,8 +214,42 @@ static void Process_Cursor_Motion(struct ACNCageServer* server, uint32_t time_ms
     }
 }
 
+void ACNCageServer_FlushCursorMotion(struct ACNCageServer* server) {
+    if (!server->cursorMotionQueued) return;
+
+    Process_Queued_Cursor_Motion(server);
+    wlr_seat_pointer_notify_frame(server->seat);
+}
+
+static void Queue_Cursor_Motion(struct ACNCageServer* server, uint32_t time_msec) {
+    enum ACNCagePointerCoalescing coalescing = server->config.pointerCoalescing;
+    if (coalescing == ACNCAGE_POINTER_COALESCING_NONE) {
+        Process_Cursor_Motion(server, time_msec);
+        return;
+    }
+
+    // The cursor has moved already, only focus & motion events are deferred
+    server->cursorMotionQueued = true;
+    server->cursorMotionTime = time_msec;
+
+    // The output under the cursor flushes the motion on its next frame
+    if (coalescing == ACNCAGE_POINTER_COALESCING_OUTPUT) {
+        struct wlr_output* wlr_output = wlr_output_layout_output_at(
+            server->output_layout, server->cursor->x, server->cursor->y);
+        if (wlr_output != NULL) wlr_output_schedule_frame(wlr_output);
+    }
+}
+
+static void Process_Queued_Cursor_Motion(struct ACNCageServer* server) {
+    if (!server->cursorMotionQueued) return;
+
+    // Reported at the cursor's final position
+    server->cursorMotionQueued = false;
+    Process_Cursor_Motion(server, server->cursorMotionTime);
+}
+
 static int Create_CursorMotion_Listener(struct ACNCageServer* server) {
-    server->cursorMotionListener.notify = Cursor_Motion;
+    server->cursorMotionListener.notify = ACNCAGE_DISPATCH(Cursor_Motion);
     wl_signal_add(&server->cursor->events.motion, &server->cursorMotionListener);
     return 0;
 }
@@ -122,13 +260,15 @@ static void Cursor_Motion(struct wl_listener* listener, void* data) {
         wl_container_of(listener, server, cursorMotionListener);
     struct wlr_pointer_motion_event* event = data;
 
+    ACNCageLatency_StampInput(&server->inputStamp);
     wlr_cursor_move(server->cursor, &event->pointer->base, event->delta_x,
                     event->delta_y);
-    Process_Cursor_Motion(server, event->time_msec);
+    Queue_Cursor_Motion(server, event->time_msec);
 }
 
 static int Create_CursorMotionAbsolute_Listener(struct ACNCageServer* server) {
-    server->cursorMotionAbsoluteListener.notify = Cursor_MotionAbsolute;
+    server->cursorMotionAbsoluteListener.notify =
+        ACNCAGE_DISPATCH(Cursor_MotionAbsolute);
     wl_signal_add(&server->cursor->events.motion_absolute,
                   &server->cursorMotionAbsoluteListener);
     return 0;
@@ -140,13 +280,14 @@ static void Cursor_MotionAbsolute(struct wl_listener* listener, void* data) {
         wl_container_of(listener, server, cursorMotionAbsoluteListener);
     struct wlr_pointer_motion_absolute_event* event = data;
 
+    ACNCageLatency_StampInput(&server->inputStamp);
     wlr_cursor_warp_absolute(server->cursor, &event->pointer->base, event->x,
                              event->y);
-    Process_Cursor_Motion(server, event->time_msec);
+    Queue_Cursor_Motion(server, event->time_msec);
 }
 
 static int Create_CursorButton_Listener(struct ACNCageServer* server) {
-    server->cursorButtonListener.notify = Cursor_Button;
+    server->cursorButtonListener.notify = ACNCAGE_DISPATCH(Cursor_Button);
     wl_signal_add(&server->cursor->events.button, &server->cursorButtonListener);
     return 0;
 }
@@ -157,6 +298,11 @@ static void Cursor_Button(struct wl_listener* listener, void* data) {
         wl_container_of(listener, server, cursorButtonListener);
     struct wlr_pointer_button_event* event = data;
 
+    ACNCageLatency_StampInput(&server->inputStamp);
+
+    // The button lands where the pointer moved to
+    Process_Queued_Cursor_Motion(server);
+
     // Notify the client w. pointer focus, that a button event has occurred
     wlr_seat_pointer_notify_button(server->seat, event->time_msec, event->button,
                                    event->state);
@@ -172,7 +318,7 @@ static void Cursor_Button(struct wl_listener* listener, void* data) {
 }
 
 static int Create_CursorAxis_Listener(struct ACNCageServer* server) {
-    server->cursorAxisListener.notify = Cursor_Axis;
+    server->cursorAxisListener.notify = ACNCAGE_DISPATCH(Cursor_Axis);
     wl_signal_add(&server->cursor->events.axis, &server->cursorAxisListener);
     return 0;
 }
@@ -183,22 +329,36 @@ static void Cursor_Axis(struct wl_listener* listener, void* data) {
         wl_container_of(listener, server, cursorAxisListener);
     struct wlr_pointer_axis_event* event = data;
 
+    ACNCageLatency_StampInput(&server->inputStamp);
+
+    // The scroll lands where the pointer moved to
+    Process_Queued_Cursor_Motion(server);
+
     // Notify the client w. pointer focus, that an axis event has occurred
     wlr_seat_pointer_notify_axis(server->seat, event->time_msec, event->orientation,
                                  event->delta, event->delta_discrete, event->source);
 }
 
 static int Create_CursorFrame_Listener(struct ACNCageServer* server) {
-    server->cursorFrameListener.notify = Cursor_Frame;
+    server->cursorFrameListener.notify = ACNCAGE_DISPATCH(Cursor_Frame);
     wl_signal_add(&server->cursor->events.frame, &server->cursorFrameListener);
     return 0;
 }
 
 // Raise by the cursor, when a pointer emits a frame event
-static void Cursor_Frame(struct wl_listener* listener, void* data) {
+static void Cursor_Frame(struct wl_listener* listener,
+                         void* data __attribute__((unused))) {
     struct ACNCageServer* server =
         wl_container_of(listener, server, cursorFrameListener);
 
+    // Per output frame, the coalesced motion ends its own pointer frame
+    if (server->cursorMotionQueued &&
+        server->config.pointerCoalescing == ACNCAGE_POINTER_COALESCING_OUTPUT)
+        return;
+
+    // Per pointer frame, motion is processed once for the whole frame
+    Process_Queued_Cursor_Motion(server);
+
     // Notify the client w. pointer focus, that a frame event has occurred
     wlr_seat_pointer_notify_frame(server->seat);
 }
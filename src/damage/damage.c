@@ -0,0 +1,53 @@
+#include "damage.h"
+
+#include <inttypes.h>  // PRIu64
+
+#include <wlr/util/log.h>  // wlr_log
+
+void ACNCageDamage_account(struct ACNCageDamageStats* stats,
+                           const pixman_region32_t* damage,
+                           int width,
+                           int height) {
+    if (width <= 0 || height <= 0) return;
+
+    pixman_region32_t clipped;
+    pixman_region32_init(&clipped);
+    pixman_region32_intersect_rect(&clipped, (pixman_region32_t*)damage, 0, 0,
+                                   width, height);
+
+    int count = pixman_region32_n_rects(&clipped);
+    uint64_t pixels = ACNCageDamage_area(&clipped);
+    pixman_region32_fini(&clipped);
+
+    ++stats->frames;
+    if (pixels == (uint64_t)width * height) ++stats->fullFrames;
+    stats->rects += count;
+    stats->pixels += pixels;
+}
+
+uint64_t ACNCageDamage_area(const pixman_region32_t* region) {
+    // Rectangles of a region never overlap, their areas add up
+    int count = 0;
+    const pixman_box32_t* rects =
+        pixman_region32_rectangles((pixman_region32_t*)region, &count);
+    uint64_t pixels = 0;
+    for (int i = 0; i < count; ++i) {
+        const pixman_box32_t* rect = &rects[i];
+        pixels += (uint64_t)(rect->x2 - rect->x1) * (rect->y2 - rect->y1);
+    }
+    return pixels;
+}
+
+void ACNCageDamage_log(const struct ACNCageDamageStats* stats, const char* label) {
+    if (stats->frames == 0) {
+        wlr_log(WLR_INFO, "%s: no damage", label);
+        return;
+    }
+
+    wlr_log(WLR_INFO,
+            "%s: %" PRIu64 " px & %.1f rects per frame, %.1f%% full redraws"
+            " (%" PRIu64 " frames)",
+            label, stats->pixels / stats->frames,
+            (double)stats->rects / stats->frames,
+            100.0 * stats->fullFrames / stats->frames, stats->frames);
+}
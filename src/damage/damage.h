@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>  // uint64_t
+
+#include <pixman.h>  // pixman_region32_t
+
+// Damage accumulated over the frames (or commits) of an output or a view
+struct ACNCageDamageStats {
+    uint64_t frames;
+    uint64_t fullFrames;  // Frames whose damage covered the whole area
+    uint64_t rects;       // Damage rectangles, summed over all frames
+    uint64_t pixels;      // Damaged pixels, summed over all frames
+};
+
+/**
+ * Account the damage of a frame
+ * Note: Damage outside of the width x height area is ignored
+ * :param  stats: stats to update
+ * :param damage: damage of the frame
+ * :param  width: width of the damaged area, in the damage's coordinates
+ * :param height: height of the damaged area, in the damage's coordinates
+ */
+void ACNCageDamage_account(struct ACNCageDamageStats* stats,
+                           const pixman_region32_t* damage,
+                           int width,
+                           int height);
+
+/**
+ * Compute the area of a damage region
+ * :param region: damage region
+ * :return: Damaged pixels
+ */
+uint64_t ACNCageDamage_area(const pixman_region32_t* region);
+
+/**
+ * Log the damage statistics
+ * :param stats: stats to report
+ * :param label: prefix of the log line
+ */
+void ACNCageDamage_log(const struct ACNCageDamageStats* stats, const char* label);
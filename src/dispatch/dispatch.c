@@ -0,0 +1,91 @@
+#include "dispatch.h"
+
+#include <inttypes.h>  // PRIu64
+#include <string.h>    // strrchr
+#include <time.h>      // clock_gettime
+
+#include <wlr/util/log.h>  // wlr_log
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_USEC 1000
+#define NSEC_PER_MSEC 1000000
+
+// Process-wide, as trampolines only get to see their listener
+static bool timingEnabled;
+static int64_t budgetNsec;
+static struct ACNCageDispatchStats* registeredStats;
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static const char* Short_Name(const char* name);
+
+/****************************************/
+
+void ACNCageDispatch_init(bool enabled, int budgetUs) {
+    timingEnabled = enabled;
+    budgetNsec = (int64_t)budgetUs * NSEC_PER_USEC;
+    if (enabled)
+        wlr_log(WLR_INFO, "Listener dispatch timing enabled, budget %d us",
+                budgetUs);
+}
+
+wl_notify_func_t ACNCageDispatch_select(struct ACNCageDispatchStats* stats,
+                                        wl_notify_func_t plain,
+                                        wl_notify_func_t timed) {
+    if (!timingEnabled) return plain;
+
+    if (!stats->registered) {
+        stats->registered = true;
+        stats->next = registeredStats;
+        registeredStats = stats;
+    }
+    return timed;
+}
+
+int64_t ACNCageDispatch_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+void ACNCageDispatch_record(struct ACNCageDispatchStats* stats, int64_t start) {
+    int64_t elapsed = ACNCageDispatch_now() - start;
+
+    ++stats->calls;
+    stats->totalNsec += elapsed;
+    if (elapsed > stats->maxNsec) stats->maxNsec = elapsed;
+
+    if (budgetNsec == 0 || elapsed <= budgetNsec) return;
+    ++stats->overBudget;
+    wlr_log(WLR_INFO, "Slow handler %s: %.2f ms", Short_Name(stats->name),
+            (double)elapsed / NSEC_PER_MSEC);
+}
+
+void ACNCageDispatch_log(void) {
+    for (struct ACNCageDispatchStats* stats = registeredStats; stats != NULL;
+         stats = stats->next) {
+        if (stats->calls == 0) continue;
+
+        wlr_log(WLR_INFO,
+                "Handler %s: %" PRIu64 " calls, avg %.3f ms, max %.3f ms, %" PRIu64
+                " over budget",
+                Short_Name(stats->name), stats->calls,
+                (double)stats->totalNsec / stats->calls / NSEC_PER_MSEC,
+                (double)stats->maxNsec / NSEC_PER_MSEC, stats->overBudget);
+    }
+}
+
+// Keeps the module directory & file, e.g. "output/listener.c:Frame_Request"
+static const char* Short_Name(const char* name) {
+    const char* separator = strrchr(name, ':');
+    const char* start = name;
+    int slashes = 0;
+    for (const char* cursor = separator; cursor != NULL && cursor > name; --cursor) {
+        if (cursor[-1] == '/' && ++slashes == 2) {
+            start = cursor;
+            break;
+        }
+    }
+    return start;
+}
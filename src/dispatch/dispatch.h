@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint64_t
+
+#include <wayland-server-core.h>  // wl_listener, wl_notify_func_t
+
+// Dispatch statistics of a listener's notify function
+struct ACNCageDispatchStats {
+    const char* name;  // Source file & handler, e.g. ".../listener.c:Frame_Request"
+    uint64_t calls;
+    int64_t totalNsec;
+    int64_t maxNsec;
+    uint64_t overBudget;  // Calls which went over the budget
+
+    struct ACNCageDispatchStats* next;  // Registered stats, see ACNCageDispatch_log
+    bool registered;
+};
+
+/**
+ * Define the timed trampoline of a notify function, at file scope, after the
+ * notify function's declaration
+ * The trampoline is registered in place of the handler when timing is on, see
+ * ACNCAGE_DISPATCH
+ * :param handler: notify function, e.g. Frame_Request
+ */
+#define ACNCAGE_DISPATCH_DEFINE(handler)                                         \
+    static struct ACNCageDispatchStats handler##_DispatchStats = {              \
+        .name = __FILE__ ":" #handler};                                         \
+    static void handler##_Timed(struct wl_listener* listener, void* data) {    \
+        int64_t start = ACNCageDispatch_now();                                 \
+        handler(listener, data);                                                \
+        ACNCageDispatch_record(&handler##_DispatchStats, start);                \
+    }
+
+/**
+ * Pick the notify function to register: the plain handler when timing is off
+ * (zero overhead), its timed trampoline otherwise
+ * Note: Requires ACNCAGE_DISPATCH_DEFINE(handler) in the same file
+ * :param handler: notify function, e.g. Frame_Request
+ */
+#define ACNCAGE_DISPATCH(handler)                                              \
+    ACNCageDispatch_select(&handler##_DispatchStats, handler, handler##_Timed)
+
+/**
+ * Enable (or not) dispatch timing, before any listener gets registered
+ * :param   enabled: whether to time the listeners
+ * :param budgetUs: handlers running longer than this are logged, 0 to never log
+ */
+void ACNCageDispatch_init(bool enabled, int budgetUs);
+
+/**
+ * Pick the notify function to register, see ACNCAGE_DISPATCH
+ * :param  stats: statistics of the handler, registered on first use
+ * :param plain: handler
+ * :param timed: timed trampoline of the handler
+ * :return: Notify function to register
+ */
+wl_notify_func_t ACNCageDispatch_select(struct ACNCageDispatchStats* stats,
+                                        wl_notify_func_t plain,
+                                        wl_notify_func_t timed);
+
+/**
+ * Read the monotonic clock
+ * :return: Current time in ns
+ */
+int64_t ACNCageDispatch_now(void);
+
+/**
+ * Account a handler call, & log it if it went over the budget
+ * :param stats: statistics of the handler
+ * :param start: time the call started, in ns
+ */
+void ACNCageDispatch_record(struct ACNCageDispatchStats* stats, int64_t start);
+
+/**
+ * Log the statistics of every handler called so far
+ */
+void ACNCageDispatch_log(void);
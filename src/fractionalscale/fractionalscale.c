@@ -0,0 +1,167 @@
+#include "fractionalscale.h"
+
+#include <stdlib.h>  // calloc, free
+
+#include <wlr/types/wlr_compositor.h>  // wlr_surface
+#include <wlr/types/wlr_output.h>      // wlr_output
+#include <wlr/util/addon.h>            // wlr_addon
+#include <wlr/util/log.h>              // wlr_log
+
+#include "fractional-scale-v1-protocol.h"  // wp_fractional_scale_*_v1
+
+#define FRACTIONAL_SCALE_MANAGER_VERSION 1
+// Scales are sent as a fraction w. this denominator
+#define SCALE_DENOMINATOR 120
+
+// Fractional scale object of a surface
+struct ACNCageFractionalScale {
+    struct wl_resource* resource;
+    struct wlr_surface* surface;
+    struct wl_list link;
+    struct wlr_addon addon;  // Attached to the surface, owned by the manager
+
+    uint32_t preferredScale;  // In 1/120ths, 0 until sent
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Destroy_FractionalScale(struct ACNCageFractionalScale* fractionalScale);
+static void Send_Preferred_Scale(struct ACNCageFractionalScale* fractionalScale);
+
+/** wp_fractional_scale_manager_v1 **/
+static void Manager_GetFractionalScale(struct wl_client* client,
+                                       struct wl_resource* resource, uint32_t id,
+                                       struct wl_resource* surfaceResource);
+
+/** wp_fractional_scale_v1 **/
+static void FractionalScale_ResourceDestroy(struct wl_resource* resource);
+
+/** Surface addon **/
+static void Addon_Destroy(struct wlr_addon* addon);
+
+/****************************************/
+
+static const struct wp_fractional_scale_manager_v1_interface managerImpl = {
+    .destroy = ACNCageGlobal_DestroyResource,
+    .get_fractional_scale = Manager_GetFractionalScale,
+};
+
+static const struct wp_fractional_scale_v1_interface fractionalScaleImpl = {
+    .destroy = ACNCageGlobal_DestroyResource,
+};
+
+static const struct wlr_addon_interface addonImpl = {
+    .name = "acncage_fractional_scale",
+    .destroy = Addon_Destroy,
+};
+
+struct ACNCageFractionalScaleManager* ACNCageFractionalScaleManager_create(
+    struct wl_display* wl_display) {
+    struct ACNCageFractionalScaleManager* manager =
+        calloc(1, sizeof(struct ACNCageFractionalScaleManager));
+    if (manager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageFractionalScaleManager");
+        return NULL;
+    }
+
+    if (ACNCageGlobal_init(&manager->global, wl_display,
+                           &wp_fractional_scale_manager_v1_interface,
+                           FRACTIONAL_SCALE_MANAGER_VERSION,
+                           &managerImpl, manager) != 0) {
+        free(manager);
+        return NULL;
+    }
+    wl_list_init(&manager->objects);
+
+    return manager;
+}
+
+void ACNCageFractionalScale_update(struct ACNCageFractionalScaleManager* manager) {
+    if (manager == NULL) return;
+
+    struct ACNCageFractionalScale* fractionalScale;
+    wl_list_for_each(fractionalScale, &manager->objects, link)
+        Send_Preferred_Scale(fractionalScale);
+}
+
+static void Destroy_FractionalScale(struct ACNCageFractionalScale* fractionalScale) {
+    wl_resource_set_user_data(fractionalScale->resource, NULL);
+    wlr_addon_finish(&fractionalScale->addon);
+    wl_list_remove(&fractionalScale->link);
+    free(fractionalScale);
+}
+
+static void Send_Preferred_Scale(struct ACNCageFractionalScale* fractionalScale) {
+    // Sharpest on the highest density output the surface is shown on
+    float scale = 0;
+    struct wlr_surface* surface = fractionalScale->surface;
+    struct wlr_surface_output* surfaceOutput;
+    wl_list_for_each(surfaceOutput, &surface->current_outputs, link) {
+        struct wlr_output* output = surfaceOutput->output;
+        if (output->scale > scale) scale = output->scale;
+    }
+    if (scale <= 0) return;  // Not shown anywhere (yet)
+
+    uint32_t preferredScale = (uint32_t)(scale * SCALE_DENOMINATOR + 0.5f);
+    if (preferredScale == fractionalScale->preferredScale) return;
+
+    fractionalScale->preferredScale = preferredScale;
+    wp_fractional_scale_v1_send_preferred_scale(fractionalScale->resource,
+                                                preferredScale);
+}
+
+static void Manager_GetFractionalScale(struct wl_client* client,
+                                       struct wl_resource* resource, uint32_t id,
+                                       struct wl_resource* surfaceResource) {
+    struct ACNCageFractionalScaleManager* manager =
+        wl_resource_get_user_data(resource);
+    struct wlr_surface* surface = wlr_surface_from_resource(surfaceResource);
+
+    // One fractional scale object per surface
+    if (wlr_addon_find(&surface->addons, manager, &addonImpl) != NULL) {
+        wl_resource_post_error(
+            resource, WP_FRACTIONAL_SCALE_MANAGER_V1_ERROR_FRACTIONAL_SCALE_EXISTS,
+            "wp_fractional_scale_v1 already exists");
+        return;
+    }
+
+    struct ACNCageFractionalScale* fractionalScale =
+        calloc(1, sizeof(struct ACNCageFractionalScale));
+    if (fractionalScale == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    fractionalScale->resource =
+        wl_resource_create(client, &wp_fractional_scale_v1_interface,
+                           wl_resource_get_version(resource), id);
+    if (fractionalScale->resource == NULL) {
+        free(fractionalScale);
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(fractionalScale->resource, &fractionalScaleImpl,
+                                   fractionalScale, FractionalScale_ResourceDestroy);
+
+    fractionalScale->surface = surface;
+    wlr_addon_init(&fractionalScale->addon, &surface->addons, manager, &addonImpl);
+    wl_list_insert(&manager->objects, &fractionalScale->link);
+
+    // Already shown somewhere, the client doesn't have to wait for a change
+    Send_Preferred_Scale(fractionalScale);
+}
+
+static void FractionalScale_ResourceDestroy(struct wl_resource* resource) {
+    struct ACNCageFractionalScale* fractionalScale =
+        wl_resource_get_user_data(resource);
+    if (fractionalScale != NULL) Destroy_FractionalScale(fractionalScale);
+}
+
+// Raise by the surface, when it goes away before its fractional scale object
+// The object is left inert, until the client destroys it
+static void Addon_Destroy(struct wlr_addon* addon) {
+    struct ACNCageFractionalScale* fractionalScale =
+        wl_container_of(addon, fractionalScale, addon);
+    Destroy_FractionalScale(fractionalScale);
+}
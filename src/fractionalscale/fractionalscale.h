@@ -0,0 +1,27 @@
+#pragma once
+
+#include <wayland-server-core.h>  // wl_list
+
+#include "global.h"  // ACNCageGlobal
+
+// wp_fractional_scale_manager_v1 global (fractional-scale-v1, staging)
+struct ACNCageFractionalScaleManager {
+    struct ACNCageGlobal global;
+    struct wl_list objects;  // ACNCageFractionalScale.link
+};
+
+/**
+ * Create the wp_fractional_scale_manager_v1 global
+ * :param wl_display: display advertising the global
+ * :return: Success the manager, Error NULL
+ */
+struct ACNCageFractionalScaleManager* ACNCageFractionalScaleManager_create(
+    struct wl_display* wl_display);
+
+/**
+ * Send the preferred scale to every surface whose outputs changed scale
+ * The preferred scale of a surface is the highest scale among its outputs
+ * Note: Only sends to surfaces whose preferred scale actually changed
+ * :param manager: manager hosting the fractional scale objects
+ */
+void ACNCageFractionalScale_update(struct ACNCageFractionalScaleManager* manager);
@@ -0,0 +1,69 @@
+#include "global.h"
+
+#include <stdlib.h>  // free
+
+#include <wlr/util/log.h>  // wlr_log
+
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+
+/***** Static function declarations *****/
+
+/** Bind global **/
+static void Global_Bind(struct wl_client* client, void* data, uint32_t version,
+                        uint32_t id);
+
+/** Destroy display **/
+static void Display_Destroy(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Display_Destroy)
+
+int ACNCageGlobal_init(struct ACNCageGlobal* global, struct wl_display* wl_display,
+                       const struct wl_interface* interface, int version,
+                       const void* implementation, void* manager) {
+    global->interface = interface;
+    global->implementation = implementation;
+    global->manager = manager;
+
+    global->global =
+        wl_global_create(wl_display, interface, version, global, Global_Bind);
+    if (global->global == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create %s global", interface->name);
+        return -1;
+    }
+
+    global->displayDestroyListener.notify = ACNCAGE_DISPATCH(Display_Destroy);
+    wl_display_add_destroy_listener(wl_display, &global->displayDestroyListener);
+    return 0;
+}
+
+void ACNCageGlobal_DestroyResource(struct wl_client* client __attribute__((unused)),
+                                   struct wl_resource* resource) {
+    wl_resource_destroy(resource);
+}
+
+// Raise by the display, when a client binds the global
+static void Global_Bind(struct wl_client* client, void* data, uint32_t version,
+                        uint32_t id) {
+    struct ACNCageGlobal* global = data;
+
+    struct wl_resource* resource =
+        wl_resource_create(client, global->interface, version, id);
+    if (resource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(resource, global->implementation,
+                                   global->manager, NULL);
+}
+
+static void Display_Destroy(struct wl_listener* listener,
+                            void* data __attribute__((unused))) {
+    struct ACNCageGlobal* global =
+        wl_container_of(listener, global, displayDestroyListener);
+
+    wl_list_remove(&global->displayDestroyListener.link);
+    wl_global_destroy(global->global);
+    free(global->manager);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <wayland-server-core.h>  // wl_global, wl_listener
+
+// Global of a protocol implemented here (not by wlroots 0.16)
+// Its manager goes away w. the display
+struct ACNCageGlobal {
+    struct wl_global* global;
+    const struct wl_interface* interface;
+    const void* implementation;  // Of bound manager resources
+    void* manager;               // Allocated w. calloc, user data of the resources
+
+    // Listeners
+    struct wl_listener displayDestroyListener;
+};
+
+/**
+ * Advertise a protocol global, binding clients to the provided implementation
+ * Note: The manager is freed once the display is destroyed
+ * :param         global: global to init, embedded in the manager
+ * :param     wl_display: display advertising the global
+ * :param      interface: manager interface
+ * :param        version: highest version supported
+ * :param implementation: manager requests
+ * :param        manager: user data of bound resources
+ * :return: Success 0, Error -1
+ */
+int ACNCageGlobal_init(struct ACNCageGlobal* global, struct wl_display* wl_display,
+                       const struct wl_interface* interface, int version,
+                       const void* implementation, void* manager);
+
+/**
+ * Handle the destroy request, of managers & the objects they create
+ * :param   client: client sending the request
+ * :param resource: resource to destroy
+ */
+void ACNCageGlobal_DestroyResource(struct wl_client* client,
+                                   struct wl_resource* resource);
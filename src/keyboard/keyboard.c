@@ -1 +1,299 @@
+#define _GNU_SOURCE  // dladdr
+
 #include "keyboard.h"
+
+#include <dlfcn.h>     // dladdr
+#include <inttypes.h>  // PRIx64
+#include <stdbool.h>   // bool
+#include <stdint.h>    // uint64_t
+#include <stdio.h>     // fopen, open_memstream, snprintf
+#include <stdlib.h>    // calloc, getenv
+#include <string.h>    // memcmp, strcmp, strdup
+#include <sys/stat.h>  // fstat, stat
+#include <unistd.h>    // getpid
+
+#include <wlr/util/log.h>  // wlr_log
+
+struct ACNCageKeymap {
+    struct xkb_keymap* xkb_keymap;
+    struct wl_list link;
+
+    char* names;  // RMLVO names joined by tabs, the cache key
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static const char* Name_Or_Default(const char* name, const char* env);
+static char* Join_Names(const struct xkb_rule_names* names);
+static char* Cache_Path(const struct ACNCageKeymapCache* cache, const char* key);
+static char* Cache_Header(const struct ACNCageKeymapCache* cache,
+                          const struct xkb_rule_names* names,
+                          const char* key);
+static void Stamp_File(FILE* stream, const char* path);
+static struct xkb_keymap* Load_Keymap(struct ACNCageKeymapCache* cache,
+                                      const char* key,
+                                      const char* header);
+static void Store_Keymap(struct ACNCageKeymapCache* cache,
+                         const char* key,
+                         const char* header,
+                         struct xkb_keymap* xkb_keymap);
+
+/****************************************/
+
+struct ACNCageKeymapCache* ACNCageKeymapCache_create(const char* directory) {
+    struct ACNCageKeymapCache* cache = calloc(1, sizeof(struct ACNCageKeymapCache));
+    if (cache == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageKeymapCache");
+        return NULL;
+    }
+    wl_list_init(&cache->keymaps);
+
+    cache->xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (cache->xkb_context == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create xkb_context");
+        ACNCageKeymapCache_destroy(cache);
+        return NULL;
+    }
+
+    if (directory != NULL) {
+        cache->directory = strdup(directory);
+        if (cache->directory == NULL) {
+            wlr_log(WLR_ERROR, "Failed to copy keymap cache directory");
+            ACNCageKeymapCache_destroy(cache);
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+void ACNCageKeymapCache_destroy(struct ACNCageKeymapCache* cache) {
+    if (cache == NULL) return;
+
+    struct ACNCageKeymap *keymap, *tmp;
+    wl_list_for_each_safe(keymap, tmp, &cache->keymaps, link) {
+        wl_list_remove(&keymap->link);
+        xkb_keymap_unref(keymap->xkb_keymap);
+        free(keymap->names);
+        free(keymap);
+    }
+
+    if (cache->xkb_context != NULL) xkb_context_unref(cache->xkb_context);
+    free(cache->directory);
+    free(cache);
+}
+
+struct xkb_keymap* ACNCageKeymapCache_get(struct ACNCageKeymapCache* cache,
+                                          const struct xkb_rule_names* names) {
+    const struct xkb_rule_names empty = {0};
+    if (names == NULL) names = &empty;
+
+    // Resolve the defaults, so that the key names the actual layout
+    const struct xkb_rule_names resolved = {
+        .rules = Name_Or_Default(names->rules, "XKB_DEFAULT_RULES"),
+        .model = Name_Or_Default(names->model, "XKB_DEFAULT_MODEL"),
+        .layout = Name_Or_Default(names->layout, "XKB_DEFAULT_LAYOUT"),
+        .variant = Name_Or_Default(names->variant, "XKB_DEFAULT_VARIANT"),
+        .options = Name_Or_Default(names->options, "XKB_DEFAULT_OPTIONS"),
+    };
+    char* key = Join_Names(&resolved);
+    if (key == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate keymap cache key");
+        return NULL;
+    }
+
+    // Already compiled
+    struct ACNCageKeymap* keymap;
+    wl_list_for_each(keymap, &cache->keymaps, link) {
+        if (strcmp(keymap->names, key) == 0) {
+            free(key);
+            return keymap->xkb_keymap;
+        }
+    }
+
+    keymap = calloc(1, sizeof(struct ACNCageKeymap));
+    if (keymap == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageKeymap");
+        free(key);
+        return NULL;
+    }
+    keymap->names = key;
+
+    // Serialized by a previous run, otherwise compiled from the XKB rules
+    char* header =
+        cache->directory != NULL ? Cache_Header(cache, &resolved, key) : NULL;
+    keymap->xkb_keymap = Load_Keymap(cache, key, header);
+    if (keymap->xkb_keymap == NULL) {
+        keymap->xkb_keymap = xkb_keymap_new_from_names(
+            cache->xkb_context, &resolved, XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (keymap->xkb_keymap == NULL) {
+            wlr_log(WLR_ERROR, "Failed to create xkb_keymap");
+            free(header);
+            free(keymap->names);
+            free(keymap);
+            return NULL;
+        }
+        Store_Keymap(cache, key, header, keymap->xkb_keymap);
+    }
+    free(header);
+
+    wl_list_insert(&cache->keymaps, &keymap->link);
+    return keymap->xkb_keymap;
+}
+
+static const char* Name_Or_Default(const char* name, const char* env) {
+    if (name != NULL && name[0] != '\0') return name;
+
+    const char* value = getenv(env);
+    return value != NULL ? value : "";
+}
+
+static char* Join_Names(const struct xkb_rule_names* names) {
+    int length = snprintf(NULL, 0, "%s\t%s\t%s\t%s\t%s", names->rules, names->model,
+                          names->layout, names->variant, names->options);
+    if (length < 0) return NULL;
+
+    char* key = malloc((size_t)length + 1);
+    if (key == NULL) return NULL;
+    snprintf(key, (size_t)length + 1, "%s\t%s\t%s\t%s\t%s", names->rules,
+             names->model, names->layout, names->variant, names->options);
+    return key;
+}
+
+static char* Cache_Path(const struct ACNCageKeymapCache* cache, const char* key) {
+    // FNV-1a of the key names the file, its header heads the file
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char* c = key; *c != '\0'; ++c) {
+        hash ^= (unsigned char)*c;
+        hash *= 0x100000001b3;
+    }
+
+    int length =
+        snprintf(NULL, 0, "%s/%016" PRIx64 ".xkb", cache->directory, hash);
+    if (length < 0) return NULL;
+
+    char* path = malloc((size_t)length + 1);
+    if (path == NULL) return NULL;
+    snprintf(path, (size_t)length + 1, "%s/%016" PRIx64 ".xkb", cache->directory,
+             hash);
+    return path;
+}
+
+// Key, followed by what compiled the keymap, as a single line
+static char* Cache_Header(const struct ACNCageKeymapCache* cache,
+                          const struct xkb_rule_names* names,
+                          const char* key) {
+    char* header = NULL;
+    size_t size = 0;
+    FILE* stream = open_memstream(&header, &size);
+    if (stream == NULL) return NULL;
+    fputs(key, stream);
+
+    // An xkbcommon upgrade may compile the same names differently
+    Dl_info library;
+    if (dladdr((void*)xkb_keymap_new_from_names, &library) != 0 &&
+        library.dli_fname != NULL)
+        Stamp_File(stream, library.dli_fname);
+
+    // So may an xkeyboard-config upgrade, or another XKB_CONFIG_ROOT
+    // Note: Unnamed rules are xkbcommon's default, evdev unless built otherwise
+    const char* rules = names->rules[0] != '\0' ? names->rules : "evdev";
+    unsigned int paths = xkb_context_num_include_paths(cache->xkb_context);
+    for (unsigned int i = 0; i < paths; ++i) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/rules/%s",
+                 xkb_context_include_path_get(cache->xkb_context, i), rules);
+        Stamp_File(stream, path);
+    }
+
+    if (fclose(stream) != 0) {
+        free(header);
+        return NULL;
+    }
+    return header;
+}
+
+static void Stamp_File(FILE* stream, const char* path) {
+    struct stat info;
+    if (stat(path, &info) == 0)
+        fprintf(stream, "\t%s %lld.%09ld %lld", path, (long long)info.st_mtim.tv_sec,
+                info.st_mtim.tv_nsec, (long long)info.st_size);
+    else
+        fprintf(stream, "\t%s -", path);
+}
+
+static struct xkb_keymap* Load_Keymap(struct ACNCageKeymapCache* cache,
+                                      const char* key,
+                                      const char* header) {
+    if (header == NULL) return NULL;
+
+    char* path = Cache_Path(cache, key);
+    if (path == NULL) return NULL;
+
+    FILE* file = fopen(path, "rb");
+    free(path);
+    if (file == NULL) return NULL;
+
+    struct stat info;
+    char* content = NULL;
+    if (fstat(fileno(file), &info) == 0 && info.st_size > 0)
+        content = malloc((size_t)info.st_size);
+    if (content == NULL ||
+        fread(content, 1, (size_t)info.st_size, file) != (size_t)info.st_size) {
+        free(content);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+
+    // The first line holds the header, guarding against hash collisions, &
+    // against keymaps compiled by another xkbcommon or from other XKB data
+    size_t headerLength = strlen(header);
+    size_t size = (size_t)info.st_size;
+    struct xkb_keymap* xkb_keymap = NULL;
+    if (size > headerLength && memcmp(content, header, headerLength) == 0 &&
+        content[headerLength] == '\n') {
+        xkb_keymap = xkb_keymap_new_from_buffer(
+            cache->xkb_context, content + headerLength + 1, size - headerLength - 1,
+            XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    }
+    free(content);
+
+    if (xkb_keymap == NULL)
+        wlr_log(WLR_INFO, "Ignoring stale keymap cache entry for %s", key);
+    return xkb_keymap;
+}
+
+static void Store_Keymap(struct ACNCageKeymapCache* cache,
+                         const char* key,
+                         const char* header,
+                         struct xkb_keymap* xkb_keymap) {
+    if (header == NULL) return;
+
+    char* path = Cache_Path(cache, key);
+    char* keymapString =
+        xkb_keymap_get_as_string(xkb_keymap, XKB_KEYMAP_FORMAT_TEXT_V1);
+    if (path == NULL || keymapString == NULL) {
+        free(path);
+        free(keymapString);
+        return;
+    }
+
+    // Written aside, then renamed, so that readers never see a partial file
+    char tmpPath[4096];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d", path, getpid());
+    FILE* file = fopen(tmpPath, "wb");
+    if (file != NULL) {
+        bool written = fprintf(file, "%s\n%s", header, keymapString) >= 0;
+        if (fclose(file) == 0 && written && rename(tmpPath, path) == 0)
+            wlr_log(WLR_DEBUG, "Stored keymap cache entry %s", path);
+        else
+            remove(tmpPath);
+    } else {
+        wlr_log_errno(WLR_ERROR, "Failed to store keymap cache entry %s", tmpPath);
+    }
+
+    free(path);
+    free(keymapString);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <wlr/types/wlr_keyboard.h>  // wlr_keyboard
+#include <xkbcommon/xkbcommon.h>     // xkb_keymap
 
 struct ACNCageKeyboard {
     struct wlr_keyboard* wlr_keyboard;
@@ -14,6 +15,36 @@ struct ACNCageKeyboard {
     struct wl_listener deviceDestroyListener;
 };
 
+// Compiled keymaps, shared by keyboards w. the same RMLVO names
+struct ACNCageKeymapCache {
+    struct xkb_context* xkb_context;
+    struct wl_list keymaps;  // ACNCageKeymap.link
+    char* directory;         // On-disk cache of serialized keymaps, NULL if disabled
+};
+
+/**
+ * Create a keymap cache, owning the xkb_context every keymap is compiled in
+ * :param directory: on-disk cache directory, NULL to keep the cache in memory only
+ * :return: Success the cache, Error NULL
+ */
+struct ACNCageKeymapCache* ACNCageKeymapCache_create(const char* directory);
+
+/**
+ * Destroy the provided keymap cache, and release every cached keymap
+ * :param cache: cache to destroy
+ */
+void ACNCageKeymapCache_destroy(struct ACNCageKeymapCache* cache);
+
+/**
+ * Get the keymap matching the provided RMLVO names, compiling it on first use
+ * Note: Unset names fall back to XKB_DEFAULT_*, as libxkbcommon does
+ * :param cache: cache to look up
+ * :param names: RMLVO names of the keymap, NULL for defaults
+ * :return: Success the keymap (owned by the cache), Error NULL
+ */
+struct xkb_keymap* ACNCageKeymapCache_get(struct ACNCageKeymapCache* cache,
+                                          const struct xkb_rule_names* names);
+
 /**
  * Create listeners for keyboard events
  * :param keyboard: keyboard hosting the listeners
@@ -1,3 +1,110 @@
 #include "keyboard.h"
 
-#include <wlr/util/log.h>  // wlr_log
+#include <wlr/types/wlr_seat.h>  // wlr_seat
+#include <wlr/util/log.h>        // wlr_log
+
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+#include "latency.h"   // ACNCageLatency_StampInput
+#include "server.h"    // ACNCageServer
+#include "slab.h"      // ACNCageSlab_free
+
+/***** Static function declarations *****/
+
+/** Keyboard modifiers event **/
+static int Create_KeyboardModifiers_Listener(struct ACNCageKeyboard* keyboard);
+static void Keyboard_Modifiers(struct wl_listener* listener, void* data);
+
+/** Keyboard key event **/
+static int Create_KeyboardKey_Listener(struct ACNCageKeyboard* keyboard);
+static void Keyboard_Key(struct wl_listener* listener, void* data);
+
+/** Device destroy **/
+static int Create_DeviceDestroy_Listener(struct ACNCageKeyboard* keyboard,
+                                         struct wlr_input_device* device);
+static void Device_Destroy(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Keyboard_Modifiers)
+ACNCAGE_DISPATCH_DEFINE(Keyboard_Key)
+ACNCAGE_DISPATCH_DEFINE(Device_Destroy)
+
+int ACNCageKeyboard_CreateListeners(struct ACNCageKeyboard* keyboard,
+                                    struct wlr_input_device* device) {
+    // Keyboard modifiers event listener
+    if (Create_KeyboardModifiers_Listener(keyboard) != 0) return -1;
+
+    // Keyboard key event listener
+    if (Create_KeyboardKey_Listener(keyboard) != 0) return -1;
+
+    // Device destroy listener
+    if (Create_DeviceDestroy_Listener(keyboard, device) != 0) return -1;
+
+    return 0;
+}
+
+static int Create_KeyboardModifiers_Listener(struct ACNCageKeyboard* keyboard) {
+    keyboard->keyboardModifiersListener.notify =
+        ACNCAGE_DISPATCH(Keyboard_Modifiers);
+    wl_signal_add(&keyboard->wlr_keyboard->events.modifiers,
+                  &keyboard->keyboardModifiersListener);
+    return 0;
+}
+
+// Raise by the keyboard, when a modifier key is pressed or released
+static void Keyboard_Modifiers(struct wl_listener* listener,
+                               void* data __attribute__((unused))) {
+    struct ACNCageKeyboard* keyboard =
+        wl_container_of(listener, keyboard, keyboardModifiersListener);
+    struct wlr_seat* seat = keyboard->server->seat;
+
+    // A seat can only have one keyboard, switch to this one
+    wlr_seat_set_keyboard(seat, keyboard->wlr_keyboard);
+
+    // Notify the client w. keyboard focus, that modifiers have changed
+    wlr_seat_keyboard_notify_modifiers(seat, &keyboard->wlr_keyboard->modifiers);
+}
+
+static int Create_KeyboardKey_Listener(struct ACNCageKeyboard* keyboard) {
+    keyboard->keyboardKeyListener.notify = ACNCAGE_DISPATCH(Keyboard_Key);
+    wl_signal_add(&keyboard->wlr_keyboard->events.key,
+                  &keyboard->keyboardKeyListener);
+    return 0;
+}
+
+// Raise by the keyboard, when a key is pressed or released
+static void Keyboard_Key(struct wl_listener* listener, void* data) {
+    struct ACNCageKeyboard* keyboard =
+        wl_container_of(listener, keyboard, keyboardKeyListener);
+    struct wlr_keyboard_key_event* event = data;
+    struct wlr_seat* seat = keyboard->server->seat;
+
+    ACNCageLatency_StampInput(&keyboard->server->inputStamp);
+
+    // A seat can only have one keyboard, switch to this one
+    wlr_seat_set_keyboard(seat, keyboard->wlr_keyboard);
+
+    // Notify the client w. keyboard focus, that a key event has occurred
+    wlr_seat_keyboard_notify_key(seat, event->time_msec, event->keycode,
+                                 event->state);
+}
+
+static int Create_DeviceDestroy_Listener(struct ACNCageKeyboard* keyboard,
+                                         struct wlr_input_device* device) {
+    keyboard->deviceDestroyListener.notify = ACNCAGE_DISPATCH(Device_Destroy);
+    wl_signal_add(&device->events.destroy, &keyboard->deviceDestroyListener);
+    return 0;
+}
+
+// Raise by the input device, as part of it's self-destruction process
+static void Device_Destroy(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageKeyboard* keyboard =
+        wl_container_of(listener, keyboard, deviceDestroyListener);
+
+    wl_list_remove(&keyboard->keyboardModifiersListener.link);
+    wl_list_remove(&keyboard->keyboardKeyListener.link);
+    wl_list_remove(&keyboard->deviceDestroyListener.link);
+    wl_list_remove(&keyboard->link);
+    ACNCageSlab_free(&keyboard->server->keyboardSlab, keyboard);
+}
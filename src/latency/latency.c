@@ -0,0 +1,136 @@
+#include "latency.h"
+
+#include <errno.h>     // errno
+#include <inttypes.h>  // PRIu64
+#include <string.h>    // strerror
+#include <time.h>      // clock_gettime
+
+#include <wlr/util/log.h>  // wlr_log
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_USEC 1000
+#define NSEC_PER_MSEC 1000000
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Bucket_Index(uint64_t usec);
+static uint64_t Bucket_UpperBound(int index);
+
+/****************************************/
+
+int64_t ACNCageLatency_now(void) {
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+        wlr_log(WLR_ERROR, "%s", strerror(errno));
+        return 0;
+    }
+    return (int64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec;
+}
+
+void ACNCageLatency_StampInput(struct ACNCageInputStamp* stamp) {
+    if (stamp->nsec == 0) stamp->nsec = ACNCageLatency_now();
+}
+
+void ACNCageLatency_ClientCommit(struct ACNCageInputStamp* stamp,
+                                 struct ACNCageLatencyTracker* tracker) {
+    if (stamp->nsec == 0) return;
+
+    // Keep the oldest input, if the output hasn't committed the previous one yet
+    if (tracker->commitInputNsec == 0) tracker->commitInputNsec = stamp->nsec;
+    stamp->nsec = 0;
+}
+
+void ACNCageLatency_OutputCommit(struct ACNCageLatencyTracker* tracker,
+                                 uint32_t seq,
+                                 bool noDelay) {
+    // Wait for the inflight input to be presented first
+    if (tracker->commitInputNsec == 0 || tracker->inflightInputNsec != 0) return;
+
+    tracker->inflightInputNsec = tracker->commitInputNsec;
+    tracker->inflightSeq = seq;
+    tracker->inflightNoDelay = noDelay;
+    tracker->commitInputNsec = 0;
+}
+
+void ACNCageLatency_OutputPresent(struct ACNCageLatencyTracker* tracker,
+                                  uint32_t seq,
+                                  int64_t presentNsec) {
+    // Present events of older commits
+    if (tracker->inflightInputNsec == 0 || (int32_t)(seq - tracker->inflightSeq) < 0)
+        return;
+
+    // A discarded commit ends the measurement, without a sample
+    if (presentNsec != 0)
+        ACNCageLatency_record(tracker->inflightNoDelay ? &tracker->noDelayHistogram
+                                                       : &tracker->histogram,
+                              presentNsec - tracker->inflightInputNsec);
+    tracker->inflightInputNsec = 0;
+}
+
+void ACNCageLatency_record(struct ACNCageLatencyHistogram* histogram, int64_t nsec) {
+    if (nsec < 0) nsec = 0;
+
+    ++histogram->buckets[Bucket_Index((uint64_t)nsec / NSEC_PER_USEC)];
+    ++histogram->count;
+    if (nsec > histogram->maxNsec) histogram->maxNsec = nsec;
+}
+
+void ACNCageLatency_merge(struct ACNCageLatencyHistogram* destination,
+                          const struct ACNCageLatencyHistogram* source) {
+    for (int i = 0; i < ACNCAGE_LATENCY_BUCKETS; ++i)
+        destination->buckets[i] += source->buckets[i];
+    destination->count += source->count;
+    if (source->maxNsec > destination->maxNsec)
+        destination->maxNsec = source->maxNsec;
+}
+
+int64_t ACNCageLatency_percentile(const struct ACNCageLatencyHistogram* histogram,
+                                  double percentile) {
+    if (histogram->count == 0) return 0;
+
+    // Rank of the sample holding the percentile, 1-based
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)histogram->count);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < ACNCAGE_LATENCY_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if (seen < rank) continue;
+
+        // The max is tighter than the upper bound of the last bucket
+        int64_t upperNsec = (int64_t)Bucket_UpperBound(i) * NSEC_PER_USEC;
+        return upperNsec < histogram->maxNsec ? upperNsec : histogram->maxNsec;
+    }
+    return histogram->maxNsec;
+}
+
+void ACNCageLatency_log(const struct ACNCageLatencyHistogram* histogram,
+                        const char* label) {
+    wlr_log(WLR_INFO,
+            "%s: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%" PRIu64 " samples)", label,
+            (double)ACNCageLatency_percentile(histogram, 50) / NSEC_PER_MSEC,
+            (double)ACNCageLatency_percentile(histogram, 99) / NSEC_PER_MSEC,
+            (double)histogram->maxNsec / NSEC_PER_MSEC, histogram->count);
+}
+
+static int Bucket_Index(uint64_t usec) {
+    const uint64_t subBuckets = 1 << ACNCAGE_LATENCY_SUB_BITS;
+    if (usec < subBuckets) return (int)usec;
+
+    // Power of 2 range, then linear step within it
+    int msb = 63 - __builtin_clzll(usec);
+    int sub = (int)(usec >> (msb - ACNCAGE_LATENCY_SUB_BITS)) & (subBuckets - 1);
+    int index = (msb - ACNCAGE_LATENCY_SUB_BITS + 1) * subBuckets + sub;
+    return index < ACNCAGE_LATENCY_BUCKETS ? index : ACNCAGE_LATENCY_BUCKETS - 1;
+}
+
+static uint64_t Bucket_UpperBound(int index) {
+    const int subBuckets = 1 << ACNCAGE_LATENCY_SUB_BITS;
+    if (index < subBuckets) return (uint64_t)index + 1;
+
+    int msb = index / subBuckets + ACNCAGE_LATENCY_SUB_BITS - 1;
+    int sub = index % subBuckets;
+    int shift = msb - ACNCAGE_LATENCY_SUB_BITS;
+    return ((uint64_t)(subBuckets + sub + 1)) << shift;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint32_t, uint64_t
+
+// Log-linear buckets: exact below 2^SUB_BITS us, then 2^SUB_BITS per power of 2
+#define ACNCAGE_LATENCY_SUB_BITS 3
+#define ACNCAGE_LATENCY_BUCKETS 256
+
+struct ACNCageLatencyHistogram {
+    uint64_t buckets[ACNCAGE_LATENCY_BUCKETS];  // Sample counts, in us buckets
+    uint64_t count;
+    int64_t maxNsec;
+};
+
+// Earliest input event, which hasn't been answered by a client commit yet
+struct ACNCageInputStamp {
+    int64_t nsec;  // 0 if none
+};
+
+// Tracks input stamps on their way through an output, until presentation
+struct ACNCageLatencyTracker {
+    int64_t commitInputNsec;    // Carried by a client commit, awaiting output commit
+    int64_t inflightInputNsec;  // Carried by an output commit, awaiting presentation
+    uint32_t inflightSeq;       // Output commit sequence carrying the input
+    bool inflightNoDelay;       // Output commit skipped the render delay
+
+    // Output commits are always vsynced
+    struct ACNCageLatencyHistogram histogram;         // Render delay applied
+    struct ACNCageLatencyHistogram noDelayHistogram;  // Render delay skipped
+};
+
+/**
+ * Read the monotonic clock
+ * :return: Current time in ns, 0 on error
+ */
+int64_t ACNCageLatency_now(void);
+
+/**
+ * Timestamp an input event entering the seat
+ * Note: Only the earliest unanswered input event is kept
+ * :param stamp: stamp to update
+ */
+void ACNCageLatency_StampInput(struct ACNCageInputStamp* stamp);
+
+/**
+ * Hand the pending input timestamp over to a client commit
+ * :param   stamp: stamp to take from
+ * :param tracker: tracker of the output displaying the committed surface
+ */
+void ACNCageLatency_ClientCommit(struct ACNCageInputStamp* stamp,
+                                 struct ACNCageLatencyTracker* tracker);
+
+/**
+ * Attach the input carried by client commits to an output commit
+ * :param tracker: tracker of the committed output
+ * :param     seq: output commit sequence
+ * :param noDelay: whether the commit skipped the render delay (still vsynced)
+ */
+void ACNCageLatency_OutputCommit(struct ACNCageLatencyTracker* tracker,
+                                 uint32_t seq,
+                                 bool noDelay);
+
+/**
+ * Record the input-to-photon latency, once the output commit is presented
+ * :param     tracker: tracker of the presenting output
+ * :param         seq: output commit sequence being presented
+ * :param presentNsec: presentation timestamp in ns, 0 if not presented
+ */
+void ACNCageLatency_OutputPresent(struct ACNCageLatencyTracker* tracker,
+                                  uint32_t seq,
+                                  int64_t presentNsec);
+
+/**
+ * Record a latency sample
+ * :param histogram: histogram to record into
+ * :param      nsec: latency in ns
+ */
+void ACNCageLatency_record(struct ACNCageLatencyHistogram* histogram, int64_t nsec);
+
+/**
+ * Merge the samples of a histogram into another
+ * :param destination: histogram receiving the samples
+ * :param      source: histogram providing the samples
+ */
+void ACNCageLatency_merge(struct ACNCageLatencyHistogram* destination,
+                          const struct ACNCageLatencyHistogram* source);
+
+/**
+ * Estimate a percentile of the recorded latencies
+ * :param  histogram: histogram to inspect
+ * :param percentile: percentile in [0, 100]
+ * :return: Upper bound of the bucket holding the percentile, in ns
+ */
+int64_t ACNCageLatency_percentile(const struct ACNCageLatencyHistogram* histogram,
+                                  double percentile);
+
+/**
+ * Log p50/p99/max of the recorded latencies
+ * :param histogram: histogram to report on
+ * :param     label: prefix of the log line
+ */
+void ACNCageLatency_log(const struct ACNCageLatencyHistogram* histogram,
+                        const char* label);
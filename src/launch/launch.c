@@ -0,0 +1,209 @@
+#include "launch.h"
+
+#include <errno.h>        // errno
+#include <signal.h>       // sigset_t, sigemptyset
+#include <spawn.h>        // posix_spawnp
+#include <stdio.h>        // snprintf
+#include <stdlib.h>       // calloc, free, malloc
+#include <string.h>       // strerror, strlen, strncmp
+#include <sys/syscall.h>  // SYS_pidfd_open
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // close, syscall
+
+#include <wlr/types/wlr_output.h>  // wlr_output
+#include <wlr/util/log.h>          // wlr_log
+
+#include "latency.h"  // ACNCageLatency_now
+
+extern char** environ;
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static pid_t Spawn(const char* socket, char* const argv[]);
+static char** Build_Environment(const char* socket);
+static double Since_Start_Ms(struct ACNCageLaunch* launch);
+
+/** App exit **/
+static int App_Exit(int fd, uint32_t mask, void* data);
+
+/****************************************/
+
+struct ACNCageLaunch* ACNCageLaunch_spawn(struct wl_display* wl_display,
+                                          const char* socket, char* const argv[],
+                                          int64_t startNsec) {
+    struct ACNCageLaunch* launch = calloc(1, sizeof(struct ACNCageLaunch));
+    if (launch == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageLaunch");
+        return NULL;
+    }
+    launch->name = argv[0];
+    launch->pidfd = -1;
+    launch->wl_display = wl_display;
+    launch->startNsec = startNsec;
+
+    launch->pid = Spawn(socket, argv);
+    if (launch->pid <= 0) {
+        free(launch);
+        return NULL;
+    }
+    wlr_log(WLR_INFO, "App %s launched (pid %d), %.1f ms after startup",
+            launch->name, (int)launch->pid, Since_Start_Ms(launch));
+
+    // Watched through a pidfd, so that SIGCHLD stays untouched for wlroots
+    // Note: Best effort, an unwatched app just doesn't end the session
+    launch->pidfd = (int)syscall(SYS_pidfd_open, launch->pid, 0);
+    if (launch->pidfd < 0) {
+        wlr_log(WLR_ERROR, "Failed to watch app %s: %s", launch->name,
+                strerror(errno));
+        return launch;
+    }
+    struct wl_event_loop* loop = wl_display_get_event_loop(wl_display);
+    launch->exitSource = wl_event_loop_add_fd(loop, launch->pidfd,
+                                              WL_EVENT_READABLE, App_Exit, launch);
+    if (launch->exitSource == NULL)
+        wlr_log(WLR_ERROR, "Failed to watch app %s", launch->name);
+
+    return launch;
+}
+
+void ACNCageLaunch_ViewMapped(struct ACNCageLaunch* launch,
+                              struct wlr_output* output) {
+    if (launch == NULL || launch->mapNsec != 0) return;
+
+    launch->mapNsec = ACNCageLatency_now();
+    launch->output = output;
+    wlr_log(WLR_INFO, "App %s: first window mapped, %.1f ms after startup",
+            launch->name, Since_Start_Ms(launch));
+}
+
+void ACNCageLaunch_OutputCommit(struct ACNCageLaunch* launch,
+                                struct wlr_output* wlr_output) {
+    if (launch == NULL || launch->mapNsec == 0 || launch->committed) return;
+    if (launch->output != NULL && launch->output != wlr_output) return;
+
+    launch->output = wlr_output;
+    launch->commitSeq = wlr_output->commit_seq;
+    launch->committed = true;
+}
+
+void ACNCageLaunch_OutputPresent(struct ACNCageLaunch* launch,
+                                 struct wlr_output* wlr_output, uint32_t commitSeq,
+                                 bool presented) {
+    if (launch == NULL || !launch->committed || launch->presented) return;
+    if (launch->output != wlr_output || !presented ||
+        (int32_t)(commitSeq - launch->commitSeq) < 0)
+        return;
+
+    launch->presented = true;
+    wlr_log(WLR_INFO, "App %s: first frame presented on %s, %.1f ms after startup",
+            launch->name, wlr_output->name, Since_Start_Ms(launch));
+}
+
+void ACNCageLaunch_destroy(struct ACNCageLaunch* launch) {
+    if (launch == NULL) return;
+
+    if (launch->exitSource != NULL) wl_event_source_remove(launch->exitSource);
+    if (launch->pidfd >= 0) close(launch->pidfd);
+    free(launch);
+}
+
+static pid_t Spawn(const char* socket, char* const argv[]) {
+    char** envp = Build_Environment(socket);
+    if (envp == NULL) {
+        wlr_log(WLR_ERROR, "Failed to build the app's environment");
+        return -1;
+    }
+
+    // The event loop blocks the signals it handles, the app mustn't inherit that
+    // Note: Spawned before the low-latency profile applies, so neither realtime
+    // scheduling nor CPU affinity nor memory locking carry over
+    sigset_t none;
+    sigemptyset(&none);
+    posix_spawnattr_t attr;
+    if (posix_spawnattr_init(&attr) != 0) {
+        wlr_log(WLR_ERROR, "Failed to init posix_spawnattr_t");
+        free(envp[0]);
+        free(envp);
+        return -1;
+    }
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    // posix_spawn avoids copying the compositor's page tables, unlike fork
+    pid_t pid = -1;
+    int error = posix_spawnp(&pid, argv[0], NULL, &attr, argv, envp);
+    posix_spawnattr_destroy(&attr);
+    free(envp[0]);
+    free(envp);
+    if (error != 0) {
+        wlr_log(WLR_ERROR, "Failed to launch %s: %s", argv[0], strerror(error));
+        return -1;
+    }
+    return pid;
+}
+
+// The compositor's environment, w. WAYLAND_DISPLAY pointing at the socket
+// Note: envp[0] is the only string allocated, the others are borrowed
+static char** Build_Environment(const char* socket) {
+    size_t count = 0;
+    while (environ[count] != NULL) ++count;
+
+    char** envp = calloc(count + 2, sizeof(char*));
+    if (envp == NULL) return NULL;
+    size_t length = strlen("WAYLAND_DISPLAY=") + strlen(socket) + 1;
+    envp[0] = malloc(length);
+    if (envp[0] == NULL) {
+        free(envp);
+        return NULL;
+    }
+    snprintf(envp[0], length, "WAYLAND_DISPLAY=%s", socket);
+
+    size_t next = 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (strncmp(environ[i], "WAYLAND_DISPLAY=", strlen("WAYLAND_DISPLAY=")) != 0)
+            envp[next++] = environ[i];
+    }
+    return envp;
+}
+
+static double Since_Start_Ms(struct ACNCageLaunch* launch) {
+    return (double)(ACNCageLatency_now() - launch->startNsec) / 1000000;
+}
+
+// Raise by the event loop, once the app has exited
+static int App_Exit(int fd __attribute__((unused)),
+                    uint32_t mask __attribute__((unused)), void* data) {
+    struct ACNCageLaunch* launch = data;
+
+    // Note: A readable pidfd means the app exited, waitpid can't return 0 here
+    int status = 0;
+    pid_t pid = waitpid(launch->pid, &status, WNOHANG);
+    if (pid == 0) return 0;
+    if (pid == -1) {
+        // Reaped elsewhere (ECHILD), stop watching, as the fd stays readable
+        wlr_log(WLR_ERROR, "Failed to reap app %s: %s, terminating", launch->name,
+                strerror(errno));
+        wl_event_source_remove(launch->exitSource);
+        launch->exitSource = NULL;
+        close(launch->pidfd);
+        launch->pidfd = -1;
+        launch->pid = 0;
+        wl_display_terminate(launch->wl_display);
+        return 0;
+    }
+    launch->pid = 0;
+
+    if (WIFEXITED(status))
+        wlr_log(WLR_INFO, "App %s exited w. status %d, terminating", launch->name,
+                WEXITSTATUS(status));
+    else
+        wlr_log(WLR_INFO, "App %s killed by signal %d, terminating", launch->name,
+                WTERMSIG(status));
+
+    // A kiosk lives & dies w. its app
+    wl_event_source_remove(launch->exitSource);
+    launch->exitSource = NULL;
+    wl_display_terminate(launch->wl_display);
+    return 0;
+}
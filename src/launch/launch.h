@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>    // bool
+#include <stdint.h>     // int64_t, uint32_t
+#include <sys/types.h>  // pid_t
+
+#include <wayland-server-core.h>  // wl_display, wl_event_source
+
+// Kiosk app launched by the compositor, & its time to first frame
+struct ACNCageLaunch {
+    const char* name;  // argv[0]
+    pid_t pid;         // 0 once exited
+    int pidfd;         // Readable once the app exits, -1 if unwatched
+    struct wl_display* wl_display;
+    struct wl_event_source* exitSource;
+
+    // Time to first frame, relative to the compositor's startup
+    int64_t startNsec;
+    int64_t mapNsec;            // First view mapped, 0 until then
+    struct wlr_output* output;  // Output showing that view, NULL if any
+    uint32_t commitSeq;         // First output commit since the map
+    bool committed;
+    bool presented;
+};
+
+/**
+ * Launch the kiosk app, as a client of the provided display
+ * Note: The app exiting terminates the display's event loop
+ * :param wl_display: display the app connects to
+ * :param     socket: display's socket, passed to the app as WAYLAND_DISPLAY
+ * :param       argv: app command, NULL terminated
+ * :param  startNsec: compositor startup, monotonic clock
+ * :return: Success the launched app, Error NULL
+ */
+struct ACNCageLaunch* ACNCageLaunch_spawn(struct wl_display* wl_display,
+                                          const char* socket, char* const argv[],
+                                          int64_t startNsec);
+
+/**
+ * Note a view being mapped, the first one marks the app's first window
+ * Note: Does nothing if launch is NULL
+ * :param launch: launched app
+ * :param output: output showing the view, NULL if unknown
+ */
+void ACNCageLaunch_ViewMapped(struct ACNCageLaunch* launch,
+                              struct wlr_output* output);
+
+/**
+ * Note an output committing a new frame, the first one since the app's first
+ * window got mapped carries it
+ * Note: Does nothing if launch is NULL
+ * :param     launch: launched app
+ * :param wlr_output: output which committed a buffer
+ */
+void ACNCageLaunch_OutputCommit(struct ACNCageLaunch* launch,
+                                struct wlr_output* wlr_output);
+
+/**
+ * Note an output frame being presented, logs the app's time to first frame
+ * Note: Does nothing if launch is NULL
+ * :param     launch: launched app
+ * :param wlr_output: output which presented a frame
+ * :param  commitSeq: output commit presented
+ * :param  presented: whether the frame actually reached the screen
+ */
+void ACNCageLaunch_OutputPresent(struct ACNCageLaunch* launch,
+                                 struct wlr_output* wlr_output, uint32_t commitSeq,
+                                 bool presented);
+
+/**
+ * Stop watching the app, & release it
+ * Note: The app is left running, it goes away w. its Wayland connection
+ * :param launch: launched app, NULL if none
+ */
+void ACNCageLaunch_destroy(struct ACNCageLaunch* launch);
@@ -1,35 +1,141 @@
-#include <stdlib.h>  // EXIT_SUCCESS
+#include <getopt.h>  // getopt_long
+#include <stdio.h>   // fprintf
+#include <stdlib.h>  // EXIT_SUCCESS, setenv
 
 #include <wlr/util/log.h>  // wlr_log_init, wlr_log
 
-#include "server.h"  // ACNCageServer
+#include "latency.h"   // ACNCageLatency_now
+#include "probe.h"     // ACNCageProbe_bench
+#include "realtime.h"  // ACNCageRealtime_apply
+#include "server.h"    // ACNCageServer
+#include "trace.h"     // ACNCageTrace_begin, ACNCageTrace_end
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Print_Usage(const char* program);
+
+/****************************************/
+
+int main(int argc, char* argv[]) {
+    // Reference point of the app's time to first frame
+    struct ACNCageServer server = {0};
+    server.startNsec = ACNCageLatency_now();
 
-int main() {
     // Use default logger
     wlr_log_init(WLR_DEBUG, NULL);
 
+    // Options, then the app command & its arguments
+    // Note: '+' stops at the app command, leaving its own options alone
+    // Note: Settings override their environment variable, & are checked w. it
+    int probeBench = 0;
+    const struct option options[] = {
+        {"backend", required_argument, NULL, 'b'},
+        {"drm-device", required_argument, NULL, 'd'},
+        {"renderer", required_argument, NULL, 'r'},
+        {"probe-bench", no_argument, &probeBench, 1},
+        {"help", no_argument, NULL, 'h'},
+        {0},
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "+b:d:r:h", options, NULL)) != -1) {
+        switch (option) {
+            case 0:  // Flag set
+                break;
+            case 'b':
+                setenv("ACNCAGE_BACKEND", optarg, 1);
+                break;
+            case 'd':
+                setenv("ACNCAGE_DRM_DEVICE", optarg, 1);
+                break;
+            case 'r':
+                setenv("ACNCAGE_RENDERER", optarg, 1);
+                break;
+            case 'h':
+                Print_Usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                Print_Usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind < argc) server.appArgv = &argv[optind];
+
+    // Load configuration
+    if (ACNCageConfig_load(&server.config) != 0) {
+        wlr_log(WLR_ERROR, "Failed to load configuration");
+        return EXIT_FAILURE;
+    }
+
+    // Renderer comparison, instead of running as a compositor
+    if (probeBench)
+        return ACNCageProbe_bench(&server.config) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    // Trace startup, until the first client commit
+    if (ACNCageTrace_init(&server.trace, server.config.tracePath) != 0) {
+        wlr_log(WLR_ERROR, "Failed to init startup trace");
+        return EXIT_FAILURE;
+    }
+
     // Init ACNCageServer
-    struct ACNCageServer server = {0};
+    ACNCageTrace_begin(&server.trace, "ACNCageServer_init");
     if (ACNCageServer_init(&server) != 0) {
         wlr_log(WLR_ERROR, "Failed to init ACNCageServer");
         ACNCageServer_destroy(&server);
         return EXIT_FAILURE;
     }
+    ACNCageTrace_end(&server.trace, "ACNCageServer_init");
 
     // Create interfaces on ACNCageServer
+    ACNCageTrace_begin(&server.trace, "ACNCageServer_CreateInterfaces");
     if (ACNCageServer_CreateInterfaces(&server) != 0) {
         wlr_log(WLR_ERROR, "Failed to create server interfaces");
         ACNCageServer_destroy(&server);
         return EXIT_FAILURE;
     }
+    ACNCageTrace_end(&server.trace, "ACNCageServer_CreateInterfaces");
 
     // Create listeners on ACNCageServer
+    ACNCageTrace_begin(&server.trace, "ACNCageServer_CreateListeners");
     if (ACNCageServer_CreateListeners(&server) != 0) {
         wlr_log(WLR_ERROR, "Failed to create listeners");
         ACNCageServer_destroy(&server);
         return EXIT_FAILURE;
     }
+    ACNCageTrace_end(&server.trace, "ACNCageServer_CreateListeners");
+
+    // Listen for clients, & bring the outputs & inputs up
+    ACNCageTrace_begin(&server.trace, "ACNCageServer_start");
+    if (ACNCageServer_start(&server) != 0) {
+        wlr_log(WLR_ERROR, "Failed to start ACNCageServer");
+        ACNCageServer_destroy(&server);
+        return EXIT_FAILURE;
+    }
+    ACNCageTrace_end(&server.trace, "ACNCageServer_start");
+
+    // Low-latency profile, once startup allocations are out of the way
+    // Note: Best effort, the compositor still runs without it
+    if (ACNCageRealtime_apply(&server.config) != 0)
+        wlr_log(WLR_ERROR, "Failed to fully apply the low-latency profile");
+
+    // Dispatch events until terminated (SIGINT, SIGTERM)
+    wl_display_run(server.wl_display);
 
     ACNCageServer_destroy(&server);
     return EXIT_SUCCESS;
 }
+
+static void Print_Usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [OPTION]... [--] [APP [ARG]...]\n"
+            "Run APP (Wayland or X11) as a kiosk, & exit once it does\n"
+            "\n"
+            "  -b, --backend=NAME     auto, drm, headless, wayland or x11\n"
+            "  -d, --drm-device=PATH  GPU of the DRM backend & GPU renderers\n"
+            "  -r, --renderer=NAME    auto, gles2, pixman or vulkan\n"
+            "      --probe-bench      time a standard scene per renderer, & exit\n"
+            "  -h, --help             show this help, & exit\n"
+            "\n"
+            "Settings are read from the ACNCAGE_* environment variables\n",
+            program);
+}
@@ -1,11 +1,15 @@
 #include "output.h"
 
-#include <time.h>    // timespec
-#include <stdlib.h>  // free
-
 #include <wlr/util/log.h>  // wlr_log
 
-#include "server.h"  // ACNCageServer
+#include "cursor.h"           // ACNCageServer_FlushCursorMotion, _LoadCursorTheme
+#include "dispatch.h"         // ACNCAGE_DISPATCH
+#include "fractionalscale.h"  // ACNCageFractionalScale_update
+#include "launch.h"           // ACNCageLaunch_OutputCommit, _OutputPresent
+#include "server.h"           // ACNCageServer
+#include "slab.h"             // ACNCageSlab_free
+#include "trace.h"            // ACNCageTrace_FirstInstant
+#include "view.h"             // ACNCageView
 
 /***** Static function declarations *****/
 
@@ -13,16 +17,35 @@
 static int Create_FrameRequest_Listener(struct ACNCageOutput* output);
 static void Frame_Request(struct wl_listener* listener, void* data);
 
+/** Frame committed **/
+static int Create_OutputCommit_Listener(struct ACNCageOutput* output);
+static void Output_Commit(struct wl_listener* listener, void* data);
+
+/** Frame presented **/
+static int Create_OutputPresent_Listener(struct ACNCageOutput* output);
+static void Output_Present(struct wl_listener* listener, void* data);
+
 /** Output destroy **/
 static int Create_OutputDestroy_Listener(struct ACNCageOutput* output);
 static void Output_Destroy(struct wl_listener* listener, void* data);
 
 /****************************************/
 
+ACNCAGE_DISPATCH_DEFINE(Frame_Request)
+ACNCAGE_DISPATCH_DEFINE(Output_Commit)
+ACNCAGE_DISPATCH_DEFINE(Output_Present)
+ACNCAGE_DISPATCH_DEFINE(Output_Destroy)
+
 int ACNCageOutput_CreateListeners(struct ACNCageOutput* output) {
     // Render frame request listener
     if (Create_FrameRequest_Listener(output) != 0) return -1;
 
+    // Frame committed listener
+    if (Create_OutputCommit_Listener(output) != 0) return -1;
+
+    // Frame presented listener
+    if (Create_OutputPresent_Listener(output) != 0) return -1;
+
     // Output destroy listener
     if (Create_OutputDestroy_Listener(output) != 0) return -1;
 
@@ -30,7 +53,7 @@ int ACNCageOutput_CreateListeners(struct ACNCageOutput* output) {
 }
 
 static int Create_FrameRequest_Listener(struct ACNCageOutput* output) {
-    output->frameRequestListener.notify = Frame_Request;
+    output->frameRequestListener.notify = ACNCAGE_DISPATCH(Frame_Request);
     wl_signal_add(&output->wlr_output->events.frame, &output->frameRequestListener);
     return 0;
 }
@@ -41,30 +64,101 @@ static void Frame_Request(struct wl_listener* listener,
     struct ACNCageOutput* output =
         wl_container_of(listener, output, frameRequestListener);
 
-    struct wlr_scene* scene = output->server->scene;
+    ACNCageTrace_FirstInstant(&output->server->trace, "first Frame_Request");
 
-    struct wlr_scene_output* scene_output =
-        wlr_scene_get_scene_output(scene, output->wlr_output);
-    if (scene_output == NULL) {
-        wlr_log(WLR_ERROR, "Output hasn't been added to the scene-graph");
+    // Mirrors never composite the scene
+    if (output->mirror) {
+        ACNCageOutput_RenderMirror(output);
         return;
     }
 
-    // Render the scene and commit this output
-    // Note: Multiple optimization techniques are applied under the hood
-    if (!wlr_scene_output_commit(scene_output))
-        wlr_log(WLR_ERROR, "Failed to Render the scene or to Commit this output");
+    // Pointer motion coalesced since the last frame gets processed once
+    ACNCageServer_FlushCursorMotion(output->server);
 
-    struct timespec now;
-    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
-        wlr_log(WLR_ERROR, "%s", strerror(errno));
+    // Latency-critical fullscreen clients get their buffer out right away
+    if (ACNCageOutput_UpdateNoRenderDelay(output)) {
+        ACNCageOutput_render(output);
+        return;
+    }
 
-    // Undefined behavior if clock_gettime failed
-    wlr_scene_output_send_frame_done(scene_output, &now);
+    // Render as close to the vblank as the predicted render cost allows,
+    // so that clients get to submit their latest content
+    int delay = ACNCageOutput_RenderDelay(output);
+    if (delay > 0) {
+        wl_event_source_timer_update(output->scheduler.renderTimer, delay);
+        return;
+    }
+
+    ACNCageOutput_render(output);
+}
+
+static int Create_OutputCommit_Listener(struct ACNCageOutput* output) {
+    output->outputCommitListener.notify = ACNCAGE_DISPATCH(Output_Commit);
+    wl_signal_add(&output->wlr_output->events.commit,
+                  &output->outputCommitListener);
+    return 0;
+}
+
+// Raise by the output, after its pending state has been committed
+static void Output_Commit(struct wl_listener* listener, void* data) {
+    struct ACNCageOutput* output =
+        wl_container_of(listener, output, outputCommitListener);
+    struct wlr_output_event_commit* event = data;
+
+    // The cursor may need to be drawn at a new scale
+    if ((event->committed & WLR_OUTPUT_STATE_SCALE) &&
+        ACNCageServer_LoadCursorTheme(output->server) != 0)
+        wlr_log(WLR_ERROR, "Failed to load cursor theme");
+
+    // Surfaces only enter & leave outputs when the scene changes
+    // Note: Not on every frame, as each update walks every fractional scale object
+    struct ACNCageServer* server = output->server;
+    if ((event->committed & WLR_OUTPUT_STATE_SCALE) ||
+        server->fractionalScaleGeneration != server->sceneGeneration) {
+        server->fractionalScaleGeneration = server->sceneGeneration;
+        ACNCageFractionalScale_update(server->fractionalScaleManager);
+    }
+
+    if (!(event->committed & WLR_OUTPUT_STATE_BUFFER)) return;
+
+    if (output == output->server->mirrorPrimary)
+        ACNCageOutput_PublishMirror(output, event->buffer);
+    if (!output->mirror) ACNCageOutput_CountFrame(output, event->buffer);
+    if (!output->mirror)
+        ACNCageLaunch_OutputCommit(output->server->launch, output->wlr_output);
+    ACNCageLatency_OutputCommit(&output->latency, output->wlr_output->commit_seq,
+                                output->noRenderDelay);
+}
+
+static int Create_OutputPresent_Listener(struct ACNCageOutput* output) {
+    output->outputPresentListener.notify = ACNCAGE_DISPATCH(Output_Present);
+    wl_signal_add(&output->wlr_output->events.present,
+                  &output->outputPresentListener);
+    return 0;
+}
+
+// Raise by the output, when a committed frame has been presented
+static void Output_Present(struct wl_listener* listener, void* data) {
+    struct ACNCageOutput* output =
+        wl_container_of(listener, output, outputPresentListener);
+    struct wlr_output_event_present* event = data;
+
+    int64_t presentNsec = 0;
+    if (event->presented && event->when != NULL)
+        presentNsec = ACNCageOutput_TimespecToNsec(event->when);
+    ACNCageLatency_OutputPresent(&output->latency, event->commit_seq, presentNsec);
+    ACNCageLaunch_OutputPresent(output->server->launch, output->wlr_output,
+                                event->commit_seq, event->presented);
+
+    if (!event->presented || event->when == NULL) return;
+
+    // Anchors the render delay of the next frame
+    output->scheduler.lastPresent = *event->when;
+    output->scheduler.refreshNsec = event->refresh;
 }
 
 static int Create_OutputDestroy_Listener(struct ACNCageOutput* output) {
-    output->outputDestroyListener.notify = Output_Destroy;
+    output->outputDestroyListener.notify = ACNCAGE_DISPATCH(Output_Destroy);
     wl_signal_add(&output->wlr_output->events.destroy,
                   &output->outputDestroyListener);
     return 0;
@@ -76,8 +170,22 @@ static void Output_Destroy(struct wl_listener* listener,
     struct ACNCageOutput* output =
         wl_container_of(listener, output, outputDestroyListener);
 
+    ACNCageOutput_LogStats(output);
+    ACNCageOutput_DestroyScheduler(output);
+
+    if (output->fullscreenView != NULL)
+        ACNCageView_ReleaseOutput(output->fullscreenView);
+    output->wlr_output->data = NULL;
+
     wl_list_remove(&output->frameRequestListener.link);
+    wl_list_remove(&output->outputCommitListener.link);
+    wl_list_remove(&output->outputPresentListener.link);
     wl_list_remove(&output->outputDestroyListener.link);
     wl_list_remove(&output->link);
-    free(output);
+
+    // A mirror takes over, so that something is still composited
+    if (output == output->server->mirrorPrimary)
+        ACNCageOutput_PromoteMirror(output->server);
+
+    ACNCageSlab_free(&output->server->outputSlab, output);
 }
@@ -0,0 +1,159 @@
+#include "output.h"
+
+#include <wlr/render/wlr_renderer.h>  // wlr_renderer_begin, wlr_render_texture
+#include <wlr/render/wlr_texture.h>   // wlr_texture_from_buffer
+#include <wlr/types/wlr_buffer.h>     // wlr_buffer_lock, wlr_buffer_unlock
+#include <wlr/types/wlr_matrix.h>     // wlr_matrix_project_box
+#include <wlr/util/box.h>             // wlr_box
+#include <wlr/util/log.h>             // wlr_log
+
+#include "server.h"  // ACNCageServer
+
+// Mirrors showing the primary's buffers as is, each keeping up to 2 of them
+// locked (shown & pending) out of the primary's 4-buffer swapchain
+#define MAX_SCANOUT_MIRRORS 1
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static bool Can_Attach_Mirror(struct ACNCageOutput* output);
+static bool Attach_Mirror(struct ACNCageOutput* output, struct wlr_buffer* buffer);
+static bool Blit_Mirror(struct ACNCageOutput* output, struct wlr_buffer* buffer);
+
+/****************************************/
+
+void ACNCageOutput_PublishMirror(struct ACNCageOutput* output,
+                                 struct wlr_buffer* buffer) {
+    struct ACNCageServer* server = output->server;
+
+    // Kept from being recycled by the primary's swapchain, until replaced
+    if (server->mirrorBuffer != NULL) wlr_buffer_unlock(server->mirrorBuffer);
+    server->mirrorBuffer = wlr_buffer_lock(buffer);
+    ++server->mirrorSeq;
+
+    struct ACNCageOutput* mirror;
+    wl_list_for_each(mirror, &server->outputs, link) {
+        if (mirror->mirror) wlr_output_schedule_frame(mirror->wlr_output);
+    }
+}
+
+void ACNCageOutput_RenderMirror(struct ACNCageOutput* output) {
+    struct ACNCageServer* server = output->server;
+    struct wlr_buffer* buffer = server->mirrorBuffer;
+
+    // Nothing new from the primary, leave the output idle
+    if (buffer == NULL || output->mirrorSeq == server->mirrorSeq) return;
+    output->mirrorSeq = server->mirrorSeq;
+
+    // Same size & accepted by the backend, the frame is shown as is
+    if (!output->mirrorBlit && Can_Attach_Mirror(output)) {
+        if (Attach_Mirror(output, buffer)) {
+            ++output->scheduler.framesMirrored;
+            return;
+        }
+        wlr_log(WLR_DEBUG, "Output %s: can't show the primary's buffer, blitting",
+                output->wlr_output->name);
+        output->mirrorBlit = true;
+    }
+
+    if (!Blit_Mirror(output, buffer)) {
+        wlr_log(WLR_ERROR, "Output %s: failed to blit the primary's frame",
+                output->wlr_output->name);
+        return;
+    }
+    ++output->scheduler.framesMirrored;
+}
+
+void ACNCageOutput_PromoteMirror(struct ACNCageServer* server) {
+    if (server->mirrorBuffer != NULL) wlr_buffer_unlock(server->mirrorBuffer);
+    server->mirrorBuffer = NULL;
+    server->mirrorPrimary = NULL;
+
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) {
+        if (!output->mirror) continue;
+
+        // Composited from now on, the remaining mirrors follow it
+        // Note: W. the pointer drawn into its frames, see New_Output
+        output->mirror = false;
+        server->mirrorPrimary = output;
+        wlr_output_lock_software_cursors(output->wlr_output, true);
+        wlr_output_layout_add_auto(server->output_layout, output->wlr_output);
+        wlr_log(WLR_INFO, "Output %s: promoted to mirror primary",
+                output->wlr_output->name);
+        return;
+    }
+}
+
+// A mirror slower than the primary would hold its buffers for longer, & so
+// would more than a few mirrors, starving the primary's swapchain
+static bool Can_Attach_Mirror(struct ACNCageOutput* output) {
+    struct ACNCageServer* server = output->server;
+    struct ACNCageOutput* primary = server->mirrorPrimary;
+    if (primary == NULL ||
+        output->wlr_output->refresh != primary->wlr_output->refresh)
+        return false;
+
+    // Slots go to the first mirrors able to take them
+    int attached = 0;
+    struct ACNCageOutput* mirror;
+    wl_list_for_each(mirror, &server->outputs, link) {
+        if (mirror == output) return attached < MAX_SCANOUT_MIRRORS;
+        if (mirror->mirror && !mirror->mirrorBlit &&
+            mirror->wlr_output->refresh == primary->wlr_output->refresh)
+            ++attached;
+    }
+    return false;
+}
+
+static bool Attach_Mirror(struct ACNCageOutput* output, struct wlr_buffer* buffer) {
+    struct wlr_output* wlr_output = output->wlr_output;
+    if (buffer->width != wlr_output->width || buffer->height != wlr_output->height)
+        return false;
+
+    wlr_output_attach_buffer(wlr_output, buffer);
+    if (!wlr_output_test(wlr_output)) {
+        wlr_output_rollback(wlr_output);
+        return false;
+    }
+    return wlr_output_commit(wlr_output);
+}
+
+static bool Blit_Mirror(struct ACNCageOutput* output, struct wlr_buffer* buffer) {
+    struct wlr_output* wlr_output = output->wlr_output;
+    struct wlr_renderer* renderer = output->server->renderer;
+
+    // Imported once per buffer, the renderer keeps the texture w. the buffer
+    struct wlr_texture* texture = wlr_texture_from_buffer(renderer, buffer);
+    if (texture == NULL) return false;
+
+    if (!wlr_output_attach_render(wlr_output, NULL)) {
+        wlr_texture_destroy(texture);
+        return false;
+    }
+
+    // Scaled to fit, keeping the primary's aspect ratio
+    int width, height;
+    wlr_output_transformed_resolution(wlr_output, &width, &height);
+    double scale = (double)width / buffer->width;
+    if ((double)height / buffer->height < scale)
+        scale = (double)height / buffer->height;
+    struct wlr_box box = {
+        .width = (int)(buffer->width * scale),
+        .height = (int)(buffer->height * scale),
+    };
+    box.x = (width - box.width) / 2;
+    box.y = (height - box.height) / 2;
+
+    float matrix[9];
+    wlr_matrix_project_box(matrix, &box, WL_OUTPUT_TRANSFORM_NORMAL, 0,
+                           wlr_output->transform_matrix);
+
+    wlr_renderer_begin(renderer, wlr_output->width, wlr_output->height);
+    wlr_renderer_clear(renderer, (float[4]){0, 0, 0, 1});
+    wlr_render_texture_with_matrix(renderer, texture, matrix, 1);
+    wlr_renderer_end(renderer);
+    wlr_texture_destroy(texture);
+
+    return wlr_output_commit(wlr_output);
+}
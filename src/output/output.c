@@ -1 +1,432 @@
 #include "output.h"
+
+#include <errno.h>     // errno
+#include <inttypes.h>  // PRIu64
+#include <stdio.h>     // snprintf
+#include <stdlib.h>    // abs, calloc, free, qsort
+#include <string.h>    // strerror
+
+#include <pixman.h>  // pixman_region32_not_empty
+
+#include <wlr/types/wlr_screencopy_v1.h>  // wlr_screencopy_frame_v1
+#include <wlr/util/log.h>                  // wlr_log
+
+#include "client.h"       // ACNCageClient_ReleaseFrames
+#include "contenttype.h"  // ACNCageContentType_get
+#include "server.h"       // ACNCageServer
+#include "tearing.h"      // ACNCageTearing_IsAsync
+#include "view.h"         // ACNCageView
+
+// Headroom added on top of the predicted render cost
+#define RENDER_MARGIN_NSEC 1000000
+// Weight of the newest sample in the render cost moving estimate (1 / 2^n)
+#define RENDER_COST_SHIFT 3
+// Refresh mismatch tolerated by an exact mode (e.g. 59.94 Hz for 60 Hz)
+#define MODE_REFRESH_TOLERANCE_MHZ 500
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_MSEC 1000000
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static struct wlr_output_mode* Find_Static_Mode(struct ACNCageOutput* output);
+static bool Mode_Allowed(const struct wlr_output_mode* mode,
+                         const struct ACNCageConfig* config);
+static int Compare_Preferred(const void* a, const void* b);
+static int Compare_MaxRefresh(const void* a, const void* b);
+static bool Test_Mode(struct wlr_output* wlr_output, struct wlr_output_mode* mode);
+static bool Capture_Pending(struct ACNCageOutput* output);
+
+/** Render timer **/
+static int Render_Timer(void* data);
+
+/****************************************/
+
+int ACNCageOutput_SelectMode(struct wlr_output* wlr_output,
+                             const struct ACNCageConfig* config) {
+    // Not advertised, but some backends (e.g. DRM, headless) accept it anyway
+    if (config->modePolicy == ACNCAGE_MODE_POLICY_CUSTOM) {
+        wlr_output_enable(wlr_output, true);
+        wlr_output_set_custom_mode(wlr_output, config->mode.width,
+                                   config->mode.height, config->mode.refreshMhz);
+        if (wlr_output_test(wlr_output)) {
+            wlr_log(WLR_INFO, "Output %s: custom mode %d x %d @ %d",
+                    wlr_output->name, config->mode.width, config->mode.height,
+                    config->mode.refreshMhz);
+            return 0;
+        }
+        wlr_log(WLR_INFO, "Output %s: custom mode rejected, using advertised modes",
+                wlr_output->name);
+        wlr_output_rollback(wlr_output);
+    }
+
+    // Mode-less outputs (e.g. headless) only need to be enabled
+    wlr_output_enable(wlr_output, true);
+    if (wl_list_empty(&wlr_output->modes)) return 0;
+
+    int modeCount = wl_list_length(&wlr_output->modes);
+    struct wlr_output_mode** candidates =
+        calloc(modeCount, sizeof(struct wlr_output_mode*));
+    if (candidates == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate output mode candidates");
+        return -1;
+    }
+
+    int candidateCount = 0;
+    struct wlr_output_mode* mode;
+    wl_list_for_each(mode, &wlr_output->modes, link) {
+        if (Mode_Allowed(mode, config)) candidates[candidateCount++] = mode;
+    }
+    qsort(candidates, candidateCount, sizeof(struct wlr_output_mode*),
+          config->modePolicy == ACNCAGE_MODE_POLICY_MAX_REFRESH ? Compare_MaxRefresh
+                                                                : Compare_Preferred);
+
+    // Best candidate first, the next one whenever the backend rejects it
+    for (int i = 0; i < candidateCount; ++i) {
+        if (Test_Mode(wlr_output, candidates[i])) {
+            wlr_log(WLR_INFO, "Output %s: mode %d x %d @ %d", wlr_output->name,
+                    candidates[i]->width, candidates[i]->height,
+                    candidates[i]->refresh);
+            free(candidates);
+            return 0;
+        }
+    }
+    free(candidates);
+
+    wlr_log(WLR_ERROR, "Output %s: none of %d modes (%d allowed) passed the test",
+            wlr_output->name, modeCount, candidateCount);
+    return -1;
+}
+
+int ACNCageOutput_InitScheduler(struct ACNCageOutput* output) {
+    struct wl_event_loop* event_loop =
+        wl_display_get_event_loop(output->server->wl_display);
+
+    output->scheduler.renderTimer =
+        wl_event_loop_add_timer(event_loop, Render_Timer, output);
+    if (output->scheduler.renderTimer == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create render timer");
+        return -1;
+    }
+
+    return 0;
+}
+
+void ACNCageOutput_DestroyScheduler(struct ACNCageOutput* output) {
+    if (output->scheduler.renderTimer != NULL)
+        wl_event_source_remove(output->scheduler.renderTimer);
+    output->scheduler.renderTimer = NULL;
+}
+
+int ACNCageOutput_RenderDelay(struct ACNCageOutput* output) {
+    const struct ACNCageConfig* config = &output->server->config;
+    struct ACNCageFrameScheduler* scheduler = &output->scheduler;
+
+    // Without a known refresh cycle, there is no vblank to aim for
+    if (!config->renderDelay || scheduler->refreshNsec <= 0) return 0;
+
+    // With adaptive sync, the vblank waits for the frame instead
+    if (output->wlr_output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED)
+        return 0;
+    if (scheduler->lastPresent.tv_sec == 0 && scheduler->lastPresent.tv_nsec == 0)
+        return 0;
+
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+        wlr_log(WLR_ERROR, "%s", strerror(errno));
+        return 0;
+    }
+
+    int64_t budgetNsec = (int64_t)config->maxRenderTimeMs * NSEC_PER_MSEC;
+    if (budgetNsec == 0)
+        budgetNsec = scheduler->renderCostNsec + scheduler->renderCostNsec / 2 +
+                     RENDER_MARGIN_NSEC;
+
+    // Next vblank is one refresh period after the last presentation
+    int64_t untilVblankNsec =
+        ACNCageOutput_TimespecToNsec(&scheduler->lastPresent) +
+        scheduler->refreshNsec - ACNCageOutput_TimespecToNsec(&now);
+
+    int64_t delayNsec = untilVblankNsec - budgetNsec;
+    if (delayNsec < NSEC_PER_MSEC) return 0;
+    return (int)(delayNsec / NSEC_PER_MSEC);
+}
+
+void ACNCageOutput_render(struct ACNCageOutput* output) {
+    struct ACNCageFrameScheduler* scheduler = &output->scheduler;
+
+    struct wlr_scene_output* scene_output =
+        wlr_scene_get_scene_output(output->server->scene, output->wlr_output);
+    if (scene_output == NULL) {
+        wlr_log(WLR_ERROR, "Output hasn't been added to the scene-graph");
+        return;
+    }
+
+    struct timespec start;
+    if (clock_gettime(CLOCK_MONOTONIC, &start) == -1)
+        wlr_log(WLR_ERROR, "%s", strerror(errno));
+
+    // Highlighted damage fades out over the next frames, keep rendering
+    bool highlight =
+        output->server->config.damageDebug == ACNCAGE_DAMAGE_DEBUG_HIGHLIGHT;
+    bool idle = !output->wlr_output->needs_frame && !highlight &&
+                !pixman_region32_not_empty(&scene_output->damage_ring.current);
+
+    // A capture waiting on a full frame gets one, even if nothing changed
+    // Note: The scene skips damage-less commits, unless a frame is needed
+    if (idle && Capture_Pending(output)) {
+        wlr_output_update_needs_frame(output->wlr_output);
+        ++scheduler->framesCaptured;
+        idle = false;
+    }
+
+    if (idle) {
+        // Nothing changed since the last frame, leave the output idle
+        ++scheduler->framesSkipped;
+    } else {
+        // What this frame is about to redraw, in transformed output coordinates
+        int width, height;
+        wlr_output_transformed_resolution(output->wlr_output, &width, &height);
+        ACNCageDamage_account(&output->damage, &scene_output->damage_ring.current,
+                              width, height);
+
+        // Render the scene and commit this output
+        // Note: Multiple optimization techniques are applied under the hood
+        if (!wlr_scene_output_commit(scene_output))
+            wlr_log(WLR_ERROR,
+                    "Failed to Render the scene or to Commit this output");
+        ++scheduler->framesRendered;
+
+        // Feed the render cost moving estimate
+        struct timespec end;
+        if (clock_gettime(CLOCK_MONOTONIC, &end) == 0) {
+            int64_t costNsec = ACNCageOutput_TimespecToNsec(&end) -
+                               ACNCageOutput_TimespecToNsec(&start);
+            scheduler->renderCostNsec +=
+                (costNsec - scheduler->renderCostNsec) >> RENDER_COST_SHIFT;
+        }
+    }
+
+    // Clients sample their content as late as possible, right after this
+    // Undefined behavior if clock_gettime failed
+    wlr_scene_output_send_frame_done(scene_output, &start);
+    ACNCageView_SendHiddenFrameDone(output, &start);
+    ACNCageClient_ReleaseFrames(output->server, &start);
+}
+
+void ACNCageOutput_UpdateRefresh(struct ACNCageOutput* output) {
+    struct ACNCageServer* server = output->server;
+    struct wlr_output* wlr_output = output->wlr_output;
+    enum ACNCageAdaptiveSync policy = server->config.adaptiveSync;
+    if (policy == ACNCAGE_ADAPTIVE_SYNC_OFF) return;
+
+    // Video & games run at their own pace, anything else is static
+    bool dynamic = policy == ACNCAGE_ADAPTIVE_SYNC_ON;
+    if (policy == ACNCAGE_ADAPTIVE_SYNC_CONTENT && output->fullscreenView != NULL) {
+        enum ACNCageContentType type =
+            ACNCageContentType_get(server->contentTypeManager,
+                                   ACNCageView_GetSurface(output->fullscreenView));
+        dynamic = type == ACNCAGE_CONTENT_TYPE_VIDEO ||
+                  type == ACNCAGE_CONTENT_TYPE_GAME;
+    }
+
+    struct wlr_output_mode* mode =
+        dynamic ? output->baseMode : Find_Static_Mode(output);
+    bool syncEnabled =
+        wlr_output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
+    if (syncEnabled == dynamic && (mode == NULL || mode == wlr_output->current_mode))
+        return;
+
+    if (syncEnabled != dynamic) wlr_output_enable_adaptive_sync(wlr_output, dynamic);
+    if (mode != NULL && mode != wlr_output->current_mode)
+        wlr_output_set_mode(wlr_output, mode);
+
+    // Not every output supports VRR, nor every mode
+    if (!wlr_output_test(wlr_output)) {
+        wlr_log(WLR_DEBUG, "Output %s: refresh policy rejected, keeping %s",
+                wlr_output->name, syncEnabled ? "VRR" : "fixed refresh");
+        wlr_output_rollback(wlr_output);
+        return;
+    }
+    if (!wlr_output_commit(wlr_output)) {
+        wlr_log(WLR_ERROR, "Output %s: failed to commit refresh policy",
+                wlr_output->name);
+        return;
+    }
+
+    wlr_log(WLR_INFO, "Output %s: %s, %d mHz", wlr_output->name,
+            dynamic ? "VRR" : "fixed refresh", wlr_output->refresh);
+}
+
+bool ACNCageOutput_UpdateNoRenderDelay(struct ACNCageOutput* output) {
+    struct ACNCageServer* server = output->server;
+    struct ACNCageView* view = output->fullscreenView;
+
+    bool noRenderDelay = false;
+    if (view != NULL && output->scanout.active) {
+        struct wlr_surface* surface = ACNCageView_GetSurface(view);
+        noRenderDelay = server->seat->keyboard_state.focused_surface == surface &&
+                        ACNCageTearing_IsAsync(server->tearingManager, surface);
+    }
+
+    if (noRenderDelay != output->noRenderDelay)
+        wlr_log(WLR_DEBUG, "Output %s: %s the render delay",
+                output->wlr_output->name, noRenderDelay ? "skipping" : "applying");
+    output->noRenderDelay = noRenderDelay;
+    return noRenderDelay;
+}
+
+void ACNCageOutput_CountFrame(struct ACNCageOutput* output,
+                              struct wlr_buffer* buffer) {
+    struct ACNCageScanoutStats* stats = &output->scanout;
+
+    // A scanned out frame commits the client buffer itself
+    bool scanout = false;
+    if (output->fullscreenView != NULL) {
+        struct wlr_surface* surface = ACNCageView_GetSurface(output->fullscreenView);
+        scanout = surface->buffer != NULL && buffer == &surface->buffer->base;
+    }
+
+    if (scanout)
+        ++stats->scanoutFrames;
+    else
+        ++stats->compositedFrames;
+
+    if (scanout != stats->active)
+        wlr_log(WLR_DEBUG, "Output %s: direct scan-out %s", output->wlr_output->name,
+                scanout ? "enabled" : "disabled, falling back to composition");
+    stats->active = scanout;
+}
+
+int64_t ACNCageOutput_TimespecToNsec(const struct timespec* timespec) {
+    return (int64_t)timespec->tv_sec * NSEC_PER_SEC + timespec->tv_nsec;
+}
+
+void ACNCageOutput_LogStats(struct ACNCageOutput* output) {
+    const struct ACNCageFrameScheduler* scheduler = &output->scheduler;
+    wlr_log(WLR_INFO,
+            "Output %s: %" PRIu64 " frames rendered, %" PRIu64
+            " skipped, render cost %.2f ms",
+            output->wlr_output->name, scheduler->framesRendered,
+            scheduler->framesSkipped,
+            (double)scheduler->renderCostNsec / NSEC_PER_MSEC);
+    if (scheduler->framesCaptured > 0)
+        wlr_log(WLR_INFO, "Output %s: %" PRIu64 " idle frames rendered for capture",
+                output->wlr_output->name, scheduler->framesCaptured);
+    if (scheduler->framesMirrored > 0)
+        wlr_log(WLR_INFO, "Output %s: %" PRIu64 " frames mirrored (%s)",
+                output->wlr_output->name, scheduler->framesMirrored,
+                output->mirrorBlit ? "blitted" : "shown as is");
+
+    const struct ACNCageScanoutStats* scanout = &output->scanout;
+    wlr_log(WLR_INFO,
+            "Output %s: %" PRIu64 " frames scanned out directly, %" PRIu64
+            " composited",
+            output->wlr_output->name, scanout->scanoutFrames,
+            scanout->compositedFrames);
+
+    char label[64];
+    snprintf(label, sizeof(label), "Output %s: damage", output->wlr_output->name);
+    ACNCageDamage_log(&output->damage, label);
+
+    snprintf(label, sizeof(label), "Output %s: input-to-photon (vsync)",
+             output->wlr_output->name);
+    ACNCageLatency_log(&output->latency.histogram, label);
+    if (output->latency.noDelayHistogram.count == 0) return;
+    snprintf(label, sizeof(label), "Output %s: input-to-photon (no render delay)",
+             output->wlr_output->name);
+    ACNCageLatency_log(&output->latency.noDelayHistogram, label);
+}
+
+static struct wlr_output_mode* Find_Static_Mode(struct ACNCageOutput* output) {
+    int targetMhz = output->server->config.staticRefreshHz * 1000;
+    struct wlr_output_mode* baseMode = output->baseMode;
+    if (baseMode == NULL || targetMhz == 0) return baseMode;
+
+    // Same resolution, refresh closest to the target
+    struct wlr_output_mode* bestMode = baseMode;
+    struct wlr_output_mode* mode;
+    wl_list_for_each(mode, &output->wlr_output->modes, link) {
+        if (mode->width != baseMode->width || mode->height != baseMode->height ||
+            !Mode_Allowed(mode, &output->server->config))
+            continue;
+        if (abs(mode->refresh - targetMhz) < abs(bestMode->refresh - targetMhz))
+            bestMode = mode;
+    }
+    return bestMode;
+}
+
+static bool Mode_Allowed(const struct wlr_output_mode* mode,
+                         const struct ACNCageConfig* config) {
+    const struct ACNCageModeSpec* exact = &config->mode;
+    if (config->modePolicy == ACNCAGE_MODE_POLICY_EXACT &&
+        (mode->width != exact->width || mode->height != exact->height ||
+         (exact->refreshMhz != 0 &&
+          abs(mode->refresh - exact->refreshMhz) > MODE_REFRESH_TOLERANCE_MHZ)))
+        return false;
+
+    const struct ACNCageModeSpec* cap = &config->maxMode;
+    if ((cap->width != 0 && mode->width > cap->width) ||
+        (cap->height != 0 && mode->height > cap->height) ||
+        (cap->refreshMhz != 0 && mode->refresh > cap->refreshMhz))
+        return false;
+
+    return true;
+}
+
+// Preferred mode first, then by resolution, then by refresh
+static int Compare_Preferred(const void* a, const void* b) {
+    const struct wlr_output_mode* modeA = *(struct wlr_output_mode* const*)a;
+    const struct wlr_output_mode* modeB = *(struct wlr_output_mode* const*)b;
+
+    if (modeA->preferred != modeB->preferred) return modeA->preferred ? -1 : 1;
+
+    int64_t areaA = (int64_t)modeA->width * modeA->height;
+    int64_t areaB = (int64_t)modeB->width * modeB->height;
+    if (areaA != areaB) return areaA > areaB ? -1 : 1;
+
+    return modeB->refresh - modeA->refresh;
+}
+
+// Highest refresh first, then as Compare_Preferred
+static int Compare_MaxRefresh(const void* a, const void* b) {
+    const struct wlr_output_mode* modeA = *(struct wlr_output_mode* const*)a;
+    const struct wlr_output_mode* modeB = *(struct wlr_output_mode* const*)b;
+
+    if (modeA->refresh != modeB->refresh) return modeB->refresh - modeA->refresh;
+    return Compare_Preferred(a, b);
+}
+
+// Leaves the mode pending if the backend accepts it
+static bool Test_Mode(struct wlr_output* wlr_output, struct wlr_output_mode* mode) {
+    wlr_output_enable(wlr_output, true);
+    wlr_output_set_mode(wlr_output, mode);
+    if (wlr_output_test(wlr_output)) return true;
+
+    wlr_log(WLR_DEBUG, "Output %s: mode %d x %d @ %d rejected", wlr_output->name,
+            mode->width, mode->height, mode->refresh);
+    wlr_output_rollback(wlr_output);
+    return false;
+}
+
+static bool Capture_Pending(struct ACNCageOutput* output) {
+    struct ACNCageServer* server = output->server;
+    if (server->screencopyManager == NULL) return false;
+
+    // Plain copies complete w. the next frame, only those w. damage wait for it
+    struct wlr_screencopy_frame_v1* frame;
+    wl_list_for_each(frame, &server->screencopyManager->frames, link) {
+        if (frame->output == output->wlr_output && frame->buffer != NULL &&
+            !frame->with_damage)
+            return true;
+    }
+    return false;
+}
+
+// Raise by the event loop, once the render delay has elapsed
+static int Render_Timer(void* data) {
+    struct ACNCageOutput* output = data;
+    ACNCageOutput_render(output);
+    return 0;
+}
@@ -1,18 +1,169 @@
 #pragma once
 
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint64_t
+#include <time.h>     // timespec
+
+#include <wayland-server-core.h>   // wl_event_source
 #include <wlr/types/wlr_output.h>  // wlr_output
 
+#include "config.h"   // ACNCageConfig
+#include "damage.h"   // ACNCageDamageStats
+#include "latency.h"  // ACNCageLatencyTracker
+
+struct ACNCageFrameScheduler {
+    struct wl_event_source* renderTimer;  // Delays rendering toward the vblank
+    struct timespec lastPresent;          // Timestamp of the last presented frame
+    int refreshNsec;                      // Refresh period, 0 if unknown
+
+    int64_t renderCostNsec;  // Moving estimate of the render cost
+    uint64_t framesRendered;
+    uint64_t framesSkipped;
+    uint64_t framesMirrored;  // Copied from the mirror primary
+    uint64_t framesCaptured;  // Rendered while idle, for a screen capture
+};
+
+struct ACNCageScanoutStats {
+    bool active;  // Whether the last frame was scanned out directly
+    uint64_t scanoutFrames;
+    uint64_t compositedFrames;
+};
+
 struct ACNCageOutput {
     struct wlr_output* wlr_output;
     struct wl_list link;
 
     struct ACNCageServer* server;
+    struct ACNCageFrameScheduler scheduler;
+
+    // Fullscreen view covering this output, if any
+    struct ACNCageView* fullscreenView;
+    bool covered;  // Scratch flag for ACNCageView_UpdateVisibility
+    struct ACNCageScanoutStats scanout;
+    struct ACNCageLatencyTracker latency;  // Input-to-photon latency
+    struct ACNCageDamageStats damage;      // Damage of the rendered frames
+
+    // Fullscreen view hints async presentation, & is scanned out directly
+    // Note: The render delay is skipped, the frame is still vsynced
+    bool noRenderDelay;
+
+    // Mode picked when the output showed up, NULL if mode-less
+    struct wlr_output_mode* baseMode;
+
+    // Shows copies of the mirror primary's frames, instead of the scene
+    bool mirror;
+    bool mirrorBlit;     // Primary's buffer can't be shown as is, blit it
+    uint64_t mirrorSeq;  // Last mirrored frame
 
     // Listeners
     struct wl_listener frameRequestListener;
+    struct wl_listener outputCommitListener;
+    struct wl_listener outputPresentListener;
     struct wl_listener outputDestroyListener;
 };
 
+/**
+ * Enable the provided wlr_output, & stage the first mode of the configured
+ * policy that passes wlr_output_test
+ * Note: The pending state is left for the caller to commit
+ * :param wlr_output: output to configure
+ * :param     config: mode policy & caps
+ * :return: Success 0, Error -1 (no mode passed the test)
+ */
+int ACNCageOutput_SelectMode(struct wlr_output* wlr_output,
+                             const struct ACNCageConfig* config);
+
+/**
+ * Init the frame scheduler of the provided ACNCageOutput
+ * :param output: output hosting the scheduler
+ * :return: Success 0, Error -1
+ */
+int ACNCageOutput_InitScheduler(struct ACNCageOutput* output);
+
+/**
+ * Destroy the frame scheduler of the provided ACNCageOutput
+ * :param output: output hosting the scheduler
+ */
+void ACNCageOutput_DestroyScheduler(struct ACNCageOutput* output);
+
+/**
+ * Compute how long rendering can be delayed, so that it completes just before
+ * the next vblank, based on the last presentation and the predicted render cost
+ * :param output: output to render
+ * :return: Delay in ms, 0 to render right away
+ */
+int ACNCageOutput_RenderDelay(struct ACNCageOutput* output);
+
+/**
+ * Render the scene & commit the provided ACNCageOutput, then send frame done
+ * Note: The commit is skipped when the output has no pending damage
+ * :param output: output to render
+ */
+void ACNCageOutput_render(struct ACNCageOutput* output);
+
+/**
+ * Apply the refresh policy: adaptive sync, & a lower fixed refresh for static
+ * content, following the content type of the fullscreen view
+ * Note: Only commits when something changes, & leaves the output as is if the
+ * backend rejects the new state
+ * :param output: output to update
+ */
+void ACNCageOutput_UpdateRefresh(struct ACNCageOutput* output);
+
+/**
+ * Decide whether the next frame skips the render delay (it's still vsynced):
+ * the focused fullscreen view hints async presentation, & nothing else needs
+ * composition (its buffer was scanned out directly)
+ * :param output: output about to render
+ * :return: Whether the frame should skip the render delay
+ */
+bool ACNCageOutput_UpdateNoRenderDelay(struct ACNCageOutput* output);
+
+/**
+ * Account a committed frame, as either scanned out directly or composited
+ * :param output: output the frame was committed on
+ * :param buffer: buffer committed on the output
+ */
+void ACNCageOutput_CountFrame(struct ACNCageOutput* output,
+                              struct wlr_buffer* buffer);
+
+/**
+ * Hand a frame committed on the mirror primary over to the mirrors, & have
+ * them schedule a frame
+ * :param output: mirror primary
+ * :param buffer: buffer committed on the primary
+ */
+void ACNCageOutput_PublishMirror(struct ACNCageOutput* output,
+                                 struct wlr_buffer* buffer);
+
+/**
+ * Show the latest frame of the mirror primary on the provided mirror, as is
+ * when the backend accepts it, else blitted (scaled to fit)
+ * Note: Never composites the scene, & commits nothing if there's no new frame
+ * :param output: mirror to update
+ */
+void ACNCageOutput_RenderMirror(struct ACNCageOutput* output);
+
+/**
+ * Replace the mirror primary, which is going away, w. one of the mirrors
+ * Note: Call after the primary has left the outputs list
+ * :param server: server hosting the outputs
+ */
+void ACNCageOutput_PromoteMirror(struct ACNCageServer* server);
+
+/**
+ * Convert the provided timespec to ns
+ * :param timespec: time to convert
+ * :return: Time, in ns
+ */
+int64_t ACNCageOutput_TimespecToNsec(const struct timespec* timespec);
+
+/**
+ * Log the frame statistics of the provided ACNCageOutput
+ * :param output: output to report on
+ */
+void ACNCageOutput_LogStats(struct ACNCageOutput* output);
+
 /**
  * Create listeners for backend events
  * :param output: output hosting the listeners
@@ -0,0 +1,115 @@
+#include "popup.h"
+
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+#include "server.h"    // ACNCageServer
+#include "slab.h"      // ACNCageSlab_free
+
+/***** Static function declarations *****/
+
+/** Map surface **/
+static int Create_SurfaceMap_Listener(struct ACNCagePopup* popup);
+static void Surface_Map(struct wl_listener* listener, void* data);
+
+/** Unmap surface **/
+static int Create_SurfaceUnmap_Listener(struct ACNCagePopup* popup);
+static void Surface_Unmap(struct wl_listener* listener, void* data);
+
+/** Destroy surface **/
+static int Create_SurfaceDestroy_Listener(struct ACNCagePopup* popup);
+static void Surface_Destroy(struct wl_listener* listener, void* data);
+
+/** Commit surface **/
+static int Create_SurfaceCommit_Listener(struct ACNCagePopup* popup);
+static void Surface_Commit(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Surface_Map)
+ACNCAGE_DISPATCH_DEFINE(Surface_Unmap)
+ACNCAGE_DISPATCH_DEFINE(Surface_Destroy)
+ACNCAGE_DISPATCH_DEFINE(Surface_Commit)
+
+int ACNCagePopup_CreateListeners(struct ACNCagePopup* popup) {
+    //  Surface map listener
+    if (Create_SurfaceMap_Listener(popup) != 0) return -1;
+
+    //  Surface unmap listener
+    if (Create_SurfaceUnmap_Listener(popup) != 0) return -1;
+
+    //  Surface destroy listener
+    if (Create_SurfaceDestroy_Listener(popup) != 0) return -1;
+
+    //  Surface commit listener
+    if (Create_SurfaceCommit_Listener(popup) != 0) return -1;
+
+    return 0;
+}
+
+static int Create_SurfaceMap_Listener(struct ACNCagePopup* popup) {
+    popup->surfaceMapListener.notify = ACNCAGE_DISPATCH(Surface_Map);
+    wl_signal_add(&popup->wlr_xdg_popup->base->events.map,
+                  &popup->surfaceMapListener);
+    return 0;
+}
+
+// Raise by the xdg_surface, when the popup is ready to be shown
+static void Surface_Map(struct wl_listener* listener,
+                        void* data __attribute__((unused))) {
+    struct ACNCagePopup* popup =
+        wl_container_of(listener, popup, surfaceMapListener);
+
+    // The popup now sits above whatever the cursor was over
+    popup->server->sceneGeneration++;
+}
+
+static int Create_SurfaceUnmap_Listener(struct ACNCagePopup* popup) {
+    popup->surfaceUnmapListener.notify = ACNCAGE_DISPATCH(Surface_Unmap);
+    wl_signal_add(&popup->wlr_xdg_popup->base->events.unmap,
+                  &popup->surfaceUnmapListener);
+    return 0;
+}
+
+static void Surface_Unmap(struct wl_listener* listener,
+                          void* data __attribute__((unused))) {
+    struct ACNCagePopup* popup =
+        wl_container_of(listener, popup, surfaceUnmapListener);
+    popup->server->sceneGeneration++;
+}
+
+static int Create_SurfaceDestroy_Listener(struct ACNCagePopup* popup) {
+    popup->surfaceDestroyListener.notify = ACNCAGE_DISPATCH(Surface_Destroy);
+    wl_signal_add(&popup->wlr_xdg_popup->base->events.destroy,
+                  &popup->surfaceDestroyListener);
+    return 0;
+}
+
+static void Surface_Destroy(struct wl_listener* listener,
+                            void* data __attribute__((unused))) {
+    struct ACNCagePopup* popup =
+        wl_container_of(listener, popup, surfaceDestroyListener);
+    popup->server->sceneGeneration++;
+
+    wl_list_remove(&popup->surfaceMapListener.link);
+    wl_list_remove(&popup->surfaceUnmapListener.link);
+    wl_list_remove(&popup->surfaceDestroyListener.link);
+    wl_list_remove(&popup->surfaceCommitListener.link);
+
+    ACNCageSlab_free(&popup->server->popupSlab, popup);
+}
+
+static int Create_SurfaceCommit_Listener(struct ACNCagePopup* popup) {
+    popup->surfaceCommitListener.notify = ACNCAGE_DISPATCH(Surface_Commit);
+    wl_signal_add(&popup->wlr_xdg_popup->base->surface->events.commit,
+                  &popup->surfaceCommitListener);
+    return 0;
+}
+
+// Raise by the surface, when the client commits a new surface state
+static void Surface_Commit(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCagePopup* popup =
+        wl_container_of(listener, popup, surfaceCommitListener);
+
+    // Popups are short-lived & rarely commit, they may have been repositioned
+    popup->server->sceneGeneration++;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <wlr/types/wlr_xdg_shell.h>  // wlr_xdg_popup
+
+struct ACNCagePopup {
+    struct wlr_xdg_popup* wlr_xdg_popup;
+
+    struct ACNCageServer* server;
+
+    // Listeners
+    struct wl_listener surfaceMapListener;
+    struct wl_listener surfaceUnmapListener;
+    struct wl_listener surfaceDestroyListener;
+    struct wl_listener surfaceCommitListener;
+};
+
+/**
+ * Create listeners for backend events
+ * :param popup: popup hosting the listeners
+ * :return: Success 0, Error -1
+ */
+int ACNCagePopup_CreateListeners(struct ACNCagePopup* popup);
@@ -0,0 +1,206 @@
+#include "probe.h"
+
+#include <stdint.h>  // int64_t, uint32_t
+#include <stdio.h>   // printf
+#include <stdlib.h>  // malloc, free
+#include <unistd.h>  // close
+
+#include <drm_fourcc.h>  // DRM_FORMAT_XRGB8888, DRM_FORMAT_ARGB8888
+
+#include <wayland-server-core.h>  // wl_display_create, wl_display_destroy
+
+#include <wlr/util/box.h>  // wlr_box
+#include <wlr/util/log.h>  // wlr_log
+
+#include <wlr/backend/headless.h>       // wlr_headless_backend_create
+#include <wlr/render/wlr_renderer.h>    // wlr_renderer_begin_with_buffer
+#include <wlr/render/allocator.h>       // wlr_allocator_autocreate
+#include <wlr/render/drm_format_set.h>  // wlr_drm_format_set_get
+#include <wlr/types/wlr_buffer.h>       // wlr_buffer_drop
+#include <wlr/types/wlr_matrix.h>       // wlr_matrix_projection
+
+#include "latency.h"  // ACNCageLatency_now
+#include "render.h"   // ACNCageRender_OpenRenderNode, _CreateRenderer
+
+#define NSEC_PER_MSEC 1000000
+
+// Standard scene, a 1080p desktop of moving windows
+#define SCENE_WIDTH 1920
+#define SCENE_HEIGHT 1080
+#define SCENE_RECTS 64
+#define SCENE_TEXTURES 16
+#define SCENE_TEXTURE_SIZE 256
+
+#define WARMUP_FRAMES 10
+#define TIMED_FRAMES 120
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Bench_Renderer(struct wlr_backend* backend,
+                          struct wlr_renderer* renderer, const char* name);
+static struct wlr_buffer* Create_Buffer(struct wlr_renderer* renderer,
+                                        struct wlr_allocator* allocator);
+static struct wlr_texture* Create_Texture(struct wlr_renderer* renderer);
+static bool Render_Scene(struct wlr_renderer* renderer, struct wlr_buffer* buffer,
+                         struct wlr_texture* texture, int frame);
+
+/****************************************/
+
+int ACNCageProbe_bench(const struct ACNCageConfig* config) {
+    // Allocators are picked from the backend's buffer capabilities
+    // Note: Never started, headless outputs aren't needed to render offscreen
+    struct wl_display* display = wl_display_create();
+    if (display == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wl_display");
+        return -1;
+    }
+    struct wlr_backend* backend = wlr_headless_backend_create(display);
+    if (backend == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create the headless backend");
+        wl_display_destroy(display);
+        return -1;
+    }
+
+    // GPU renderers all run on the same device
+    int drmFd = ACNCageRender_OpenRenderNode(config->drmDevice);
+
+    static const enum ACNCageRenderer renderers[] = {
+        ACNCAGE_RENDERER_PIXMAN,
+        ACNCAGE_RENDERER_GLES2,
+        ACNCAGE_RENDERER_VULKAN,
+    };
+    static const char* const names[] = {
+        [ACNCAGE_RENDERER_GLES2] = "gles2",
+        [ACNCAGE_RENDERER_PIXMAN] = "pixman",
+        [ACNCAGE_RENDERER_VULKAN] = "vulkan",
+    };
+
+    printf("scene=%dx%d\n", SCENE_WIDTH, SCENE_HEIGHT);
+    printf("frames=%d\n", TIMED_FRAMES);
+    int benched = 0;
+    for (size_t i = 0; i < sizeof(renderers) / sizeof(renderers[0]); ++i) {
+        const char* name = names[renderers[i]];
+        struct wlr_renderer* renderer =
+            ACNCageRender_CreateRenderer(renderers[i], drmFd);
+        if (renderer == NULL || Bench_Renderer(backend, renderer, name) != 0)
+            printf("%s=unavailable\n", name);
+        else
+            ++benched;
+        if (renderer != NULL) wlr_renderer_destroy(renderer);
+    }
+
+    if (drmFd != -1) close(drmFd);
+    wlr_backend_destroy(backend);
+    wl_display_destroy(display);
+    return benched > 0 ? 0 : -1;
+}
+
+static int Bench_Renderer(struct wlr_backend* backend,
+                          struct wlr_renderer* renderer, const char* name) {
+    struct wlr_allocator* allocator = wlr_allocator_autocreate(backend, renderer);
+    struct wlr_buffer* buffer =
+        allocator != NULL ? Create_Buffer(renderer, allocator) : NULL;
+    struct wlr_texture* texture = Create_Texture(renderer);
+
+    int result = -1;
+    if (buffer == NULL || texture == NULL) {
+        wlr_log(WLR_ERROR, "Failed to set the scene up for %s", name);
+    } else {
+        int64_t totalNsec = 0;
+        int64_t maxNsec = 0;
+        int frame = 0;
+        for (; frame < WARMUP_FRAMES + TIMED_FRAMES; ++frame) {
+            int64_t startNsec = ACNCageLatency_now();
+            if (!Render_Scene(renderer, buffer, texture, frame)) break;
+            int64_t frameNsec = ACNCageLatency_now() - startNsec;
+
+            // First frames compile shaders & fault memory in
+            if (frame < WARMUP_FRAMES) continue;
+            totalNsec += frameNsec;
+            if (frameNsec > maxNsec) maxNsec = frameNsec;
+        }
+
+        if (frame == WARMUP_FRAMES + TIMED_FRAMES) {
+            printf("%s_frame_avg_ms=%.3f\n", name,
+                   (double)totalNsec / TIMED_FRAMES / NSEC_PER_MSEC);
+            printf("%s_frame_max_ms=%.3f\n", name, (double)maxNsec / NSEC_PER_MSEC);
+            result = 0;
+        } else {
+            wlr_log(WLR_ERROR, "Failed to render the scene w. %s", name);
+        }
+    }
+
+    if (texture != NULL) wlr_texture_destroy(texture);
+    if (buffer != NULL) wlr_buffer_drop(buffer);
+    if (allocator != NULL) wlr_allocator_destroy(allocator);
+    return result;
+}
+
+static struct wlr_buffer* Create_Buffer(struct wlr_renderer* renderer,
+                                        struct wlr_allocator* allocator) {
+    const struct wlr_drm_format* format = wlr_drm_format_set_get(
+        wlr_renderer_get_render_formats(renderer), DRM_FORMAT_XRGB8888);
+    if (format == NULL) return NULL;
+
+    return wlr_allocator_create_buffer(allocator, SCENE_WIDTH, SCENE_HEIGHT, format);
+}
+
+// Checkerboard, standing in for a client's shm buffer
+static struct wlr_texture* Create_Texture(struct wlr_renderer* renderer) {
+    uint32_t* pixels =
+        malloc(sizeof(uint32_t) * SCENE_TEXTURE_SIZE * SCENE_TEXTURE_SIZE);
+    if (pixels == NULL) return NULL;
+
+    for (int y = 0; y < SCENE_TEXTURE_SIZE; ++y) {
+        for (int x = 0; x < SCENE_TEXTURE_SIZE; ++x)
+            pixels[y * SCENE_TEXTURE_SIZE + x] =
+                (x / 16 + y / 16) % 2 == 0 ? 0xFF3070C0 : 0xFFE0E0E0;
+    }
+
+    struct wlr_texture* texture = wlr_texture_from_pixels(
+        renderer, DRM_FORMAT_ARGB8888, sizeof(uint32_t) * SCENE_TEXTURE_SIZE,
+        SCENE_TEXTURE_SIZE, SCENE_TEXTURE_SIZE, pixels);
+    free(pixels);
+    return texture;
+}
+
+static bool Render_Scene(struct wlr_renderer* renderer, struct wlr_buffer* buffer,
+                         struct wlr_texture* texture, int frame) {
+    if (!wlr_renderer_begin_with_buffer(renderer, buffer)) return false;
+
+    float projection[9];
+    wlr_matrix_projection(projection, SCENE_WIDTH, SCENE_HEIGHT,
+                          WL_OUTPUT_TRANSFORM_NORMAL);
+    wlr_renderer_clear(renderer, (float[4]){0.1f, 0.1f, 0.1f, 1.0f});
+
+    // Windows, opaque & translucent (premultiplied), moving every frame
+    for (int i = 0; i < SCENE_RECTS; ++i) {
+        struct wlr_box box = {
+            .x = (i * 97 + frame * 8) % (SCENE_WIDTH - 320),
+            .y = (i * 53 + frame * 4) % (SCENE_HEIGHT - 240),
+            .width = 320,
+            .height = 240,
+        };
+        float alpha = i % 2 == 0 ? 1.0f : 0.5f;
+        const float color[4] = {alpha * (i % 4) / 3.0f, alpha * (i % 3) / 2.0f,
+                                alpha * 0.5f, alpha};
+        wlr_render_rect(renderer, &box, color, projection);
+    }
+
+    // Client buffers, blended on top
+    for (int i = 0; i < SCENE_TEXTURES; ++i) {
+        int x = (i * 211 + frame * 6) % (SCENE_WIDTH - SCENE_TEXTURE_SIZE);
+        int y = (i * 131 + frame * 3) % (SCENE_HEIGHT - SCENE_TEXTURE_SIZE);
+        wlr_render_texture(renderer, texture, projection, x, y, 0.9f);
+    }
+
+    // Reading a pixel back waits for the GPU, so that its work gets timed
+    // Note: Renderers unable to read back are timed up to submission
+    uint32_t pixel;
+    wlr_renderer_read_pixels(renderer, wlr_renderer_preferred_read_format(renderer),
+                             sizeof(pixel), 1, 1, 0, 0, 0, 0, &pixel);
+
+    wlr_renderer_end(renderer);
+    return true;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "config.h"  // ACNCageConfig
+
+/**
+ * Render a standard scene offscreen, w. every renderer available, & print
+ * their frame times (key=value lines on stdout)
+ * :param config: DRM device of GPU renderers
+ * :return: Success 0, Error -1 (no renderer could run the scene)
+ */
+int ACNCageProbe_bench(const struct ACNCageConfig* config);
@@ -0,0 +1,122 @@
+#define _GNU_SOURCE  // cpu_set_t, sched_setaffinity, SCHED_RESET_ON_FORK
+
+#include "realtime.h"
+
+#include <errno.h>     // errno
+#include <sched.h>     // sched_setscheduler, sched_setaffinity
+#include <stddef.h>    // size_t
+#include <stdlib.h>    // strtol
+#include <string.h>    // strerror
+#include <sys/mman.h>  // mlockall
+#include <unistd.h>    // sysconf
+
+#include <wlr/util/log.h>  // wlr_log
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Set_Scheduler(const struct ACNCageConfig* config);
+static int Set_Affinity(const char* cpuList);
+static int Parse_Cpu_List(const char* cpuList, cpu_set_t* cpus);
+static void Prefault_Stack(size_t bytes);
+
+/****************************************/
+
+int ACNCageRealtime_apply(const struct ACNCageConfig* config) {
+    int result = 0;
+
+    if (config->schedPolicy != ACNCAGE_SCHED_OTHER && Set_Scheduler(config) != 0)
+        result = -1;
+
+    if (config->cpuAffinity != NULL && Set_Affinity(config->cpuAffinity) != 0)
+        result = -1;
+
+    // Locked first, so that the prefaulted stack stays resident
+    if (config->memoryLock) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+            wlr_log(WLR_ERROR, "Failed to lock memory: %s", strerror(errno));
+            result = -1;
+        } else {
+            wlr_log(WLR_INFO, "Memory locked");
+        }
+    }
+
+    if (config->stackPrefaultKiB > 0) {
+        Prefault_Stack((size_t)config->stackPrefaultKiB * 1024);
+        wlr_log(WLR_INFO, "Prefaulted %d KiB of stack", config->stackPrefaultKiB);
+    }
+
+    return result;
+}
+
+static int Set_Scheduler(const struct ACNCageConfig* config) {
+    int policy = config->schedPolicy == ACNCAGE_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+    struct sched_param param = {.sched_priority = config->schedPriority};
+
+    // Clients spawned by the compositor fall back to the default policy
+    if (sched_setscheduler(0, policy | SCHED_RESET_ON_FORK, &param) == -1) {
+        wlr_log(WLR_ERROR, "Failed to set %s scheduling, priority %d: %s",
+                policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR",
+                config->schedPriority, strerror(errno));
+        return -1;
+    }
+
+    wlr_log(WLR_INFO, "Scheduling: %s, priority %d",
+            policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", config->schedPriority);
+    return 0;
+}
+
+static int Set_Affinity(const char* cpuList) {
+    cpu_set_t cpus;
+    if (Parse_Cpu_List(cpuList, &cpus) != 0) {
+        wlr_log(WLR_ERROR, "Invalid CPU list: %s (expected e.g. 0,2-3)", cpuList);
+        return -1;
+    }
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+        wlr_log(WLR_ERROR, "Failed to pin to CPUs %s: %s", cpuList, strerror(errno));
+        return -1;
+    }
+
+    wlr_log(WLR_INFO, "Pinned to CPUs %s", cpuList);
+    return 0;
+}
+
+// Parses comma separated CPUs & CPU ranges, e.g. 0,2-3
+static int Parse_Cpu_List(const char* cpuList, cpu_set_t* cpus) {
+    CPU_ZERO(cpus);
+
+    const char* cursor = cpuList;
+    while (true) {
+        char* end = NULL;
+        long first = strtol(cursor, &end, 10);
+        if (end == cursor || first < 0 || first >= CPU_SETSIZE) return -1;
+
+        long last = first;
+        if (*end == '-') {
+            cursor = end + 1;
+            last = strtol(cursor, &end, 10);
+            if (end == cursor || last < first || last >= CPU_SETSIZE) return -1;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) CPU_SET(cpu, cpus);
+
+        if (*end == '\0') return 0;
+        if (*end != ',') return -1;
+        cursor = end + 1;
+    }
+}
+
+// Touches every page of the stack that is about to be used, so that growing
+// into it later never page-faults
+static void __attribute__((noinline)) Prefault_Stack(size_t bytes) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pageSize <= 0) pageSize = 4096;
+
+    volatile unsigned char stack[bytes];
+    unsigned char sum = 0;
+    for (size_t i = 0; i < bytes; i += (size_t)pageSize) {
+        stack[i] = 0;
+        sum += stack[i];
+    }
+    (void)sum;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "config.h"  // ACNCageConfig
+
+/**
+ * Apply the low-latency profile of the provided config to the calling thread:
+ * realtime scheduling, CPU affinity, memory locking & stack prefaulting
+ * Note: Each part is attempted, even if an earlier one failed
+ * Note: Realtime scheduling isn't inherited by child processes
+ * :param config: realtime settings
+ * :return: Success 0, Error -1 (some part couldn't be applied)
+ */
+int ACNCageRealtime_apply(const struct ACNCageConfig* config);
@@ -0,0 +1,67 @@
+#include "render.h"
+
+#include <errno.h>   // errno
+#include <fcntl.h>   // open
+#include <stdio.h>   // snprintf
+#include <string.h>  // strerror
+
+#include <wlr/config.h>    // WLR_HAS_GLES2_RENDERER, WLR_HAS_VULKAN_RENDERER
+#include <wlr/util/log.h>  // wlr_log
+
+#include <wlr/render/pixman.h>  // wlr_pixman_renderer_create
+
+#if WLR_HAS_GLES2_RENDERER
+#include <wlr/render/gles2.h>  // wlr_gles2_renderer_create_with_drm_fd
+#endif
+#if WLR_HAS_VULKAN_RENDERER
+#include <wlr/render/vulkan.h>  // wlr_vk_renderer_create_with_drm_fd
+#endif
+
+int ACNCageRender_OpenRenderNode(const char* path) {
+    if (path != NULL) {
+        int fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd == -1) wlr_log(WLR_ERROR, "%s: %s", path, strerror(errno));
+        return fd;
+    }
+
+    // Render nodes need neither a session nor DRM master
+    for (int minor = 128; minor < 192; ++minor) {
+        char node[32];
+        snprintf(node, sizeof(node), "/dev/dri/renderD%d", minor);
+        int fd = open(node, O_RDWR | O_CLOEXEC);
+        if (fd != -1) {
+            wlr_log(WLR_INFO, "Rendering on %s", node);
+            return fd;
+        }
+    }
+    wlr_log(WLR_ERROR, "Failed to find a render node");
+    return -1;
+}
+
+struct wlr_renderer* ACNCageRender_CreateRenderer(enum ACNCageRenderer renderer,
+                                                  int drmFd) {
+    if (renderer == ACNCAGE_RENDERER_PIXMAN) return wlr_pixman_renderer_create();
+
+    if (drmFd < 0) {
+        wlr_log(WLR_ERROR, "GPU renderers need a DRM device");
+        return NULL;
+    }
+    switch (renderer) {
+        case ACNCAGE_RENDERER_GLES2:
+#if WLR_HAS_GLES2_RENDERER
+            return wlr_gles2_renderer_create_with_drm_fd(drmFd);
+#else
+            wlr_log(WLR_ERROR, "wlroots was built without the GLES2 renderer");
+            return NULL;
+#endif
+        case ACNCAGE_RENDERER_VULKAN:
+#if WLR_HAS_VULKAN_RENDERER
+            return wlr_vk_renderer_create_with_drm_fd(drmFd);
+#else
+            wlr_log(WLR_ERROR, "wlroots was built without the Vulkan renderer");
+            return NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <wlr/render/wlr_renderer.h>  // wlr_renderer
+
+#include "config.h"  // ACNCageRenderer
+
+/**
+ * Open a DRM device to render with
+ * :param path: device path, NULL for the first render node that opens
+ * :return: Success file descriptor, owned by the caller, Error -1
+ */
+int ACNCageRender_OpenRenderNode(const char* path);
+
+/**
+ * Create the named renderer, rather than the one wlroots would pick
+ * Note: Renderers keep their own reference to the DRM device
+ * :param renderer: GLES2, pixman or Vulkan
+ * :param drmFd: DRM device of GPU renderers, ignored by pixman
+ * :return: Success wlr_renderer, Error NULL (incl. not built into wlroots)
+ */
+struct wlr_renderer* ACNCageRender_CreateRenderer(enum ACNCageRenderer renderer,
+                                                  int drmFd);
@@ -1,51 +1,111 @@
 #include "server.h"
 
-#include <stdlib.h>  // calloc
-
+#include <wlr/config.h>    // WLR_HAS_XWAYLAND
 #include <wlr/util/log.h>  // wlr_log
 
-#include <wlr/types/wlr_xdg_shell.h>  // wlr_xdg_shell
+#include <wlr/types/wlr_compositor.h>  // wlr_compositor
+#include <wlr/types/wlr_cursor.h>      // wlr_cursor_attach_input_device
+#include <wlr/types/wlr_seat.h>        // wlr_seat_set_capabilities
+#include <wlr/types/wlr_xdg_shell.h>   // wlr_xdg_shell
+#if WLR_HAS_XWAYLAND
+#include <wlr/xwayland.h>  // wlr_xwayland
+#endif
 
 #include "output.h"  // ACNCageOutput
 
 #include "view.h"  // ACNCageView
 
+#include "popup.h"  // ACNCagePopup
+
+#include "slab.h"  // ACNCageSlab_alloc
+
+#include "trace.h"  // ACNCageTrace_begin, ACNCageTrace_end
+
 #include "keyboard.h"  // ACNCageKeyboard
 
+#include "cursor.h"  // ACNCageServer_CreateCursorListeners
+
+#include "contenttype.h"  // ACNCageContentTypeManager
+
+#include "client.h"  // ACNCageClient_create, ACNCageClient_TrackSurface
+
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+
 /***** Static function declarations *****/
 
 /** Outputs **/
 static int Create_NewOutput_Listener(struct ACNCageServer *server);
 static void New_Output(struct wl_listener *listener, void *data);
 
+/** Clients **/
+static int Create_ClientCreated_Listener(struct ACNCageServer *server);
+static void Client_Created(struct wl_listener *listener, void *data);
+static int Create_NewSurface_Listener(struct ACNCageServer *server);
+static void New_Surface(struct wl_listener *listener, void *data);
+
 /** Shells **/
 static int Create_NewXdgSurface_Listener(struct ACNCageServer *server);
 static void New_XdgSurface(struct wl_listener *listener, void *data);
+#if WLR_HAS_XWAYLAND
+static int Create_NewXwaylandSurface_Listener(struct ACNCageServer *server);
+static void New_XwaylandSurface(struct wl_listener *listener, void *data);
+#endif
+
+/** Surface hints **/
+static int Create_ContentTypeChange_Listener(struct ACNCageServer *server);
+static void ContentType_Change(struct wl_listener *listener, void *data);
 
 /** Inputs **/
 static int Create_NewInput_Listener(struct ACNCageServer *server);
 static void New_Input(struct wl_listener *listener, void *data);
+static void New_Keyboard(struct ACNCageServer *server,
+                         struct wlr_input_device *device);
 
 /****************************************/
 
+ACNCAGE_DISPATCH_DEFINE(New_Output)
+ACNCAGE_DISPATCH_DEFINE(Client_Created)
+ACNCAGE_DISPATCH_DEFINE(New_Surface)
+ACNCAGE_DISPATCH_DEFINE(New_XdgSurface)
+#if WLR_HAS_XWAYLAND
+ACNCAGE_DISPATCH_DEFINE(New_XwaylandSurface)
+#endif
+ACNCAGE_DISPATCH_DEFINE(ContentType_Change)
+ACNCAGE_DISPATCH_DEFINE(New_Input)
+
 int ACNCageServer_CreateListeners(struct ACNCageServer *server) {
     // Outputs listeners
     wl_list_init(&server->outputs);
     if (Create_NewOutput_Listener(server) != 0) return -1;
 
+    // Clients listeners
+    wl_list_init(&server->clients);
+    if (Create_ClientCreated_Listener(server) != 0) return -1;
+    if (Create_NewSurface_Listener(server) != 0) return -1;
+
     // Shells listeners
     wl_list_init(&server->views);
     if (Create_NewXdgSurface_Listener(server) != 0) return -1;
+#if WLR_HAS_XWAYLAND
+    if (server->xwayland != NULL && Create_NewXwaylandSurface_Listener(server) != 0)
+        return -1;
+#endif
+
+    // Surface hints listeners
+    if (Create_ContentTypeChange_Listener(server) != 0) return -1;
 
     // Inputs listeners
     wl_list_init(&server->keyboards);
     if (Create_NewInput_Listener(server) != 0) return -1;
 
+    // Cursor listeners
+    if (ACNCageServer_CreateCursorListeners(server) != 0) return -1;
+
     return 0;
 }
 
 static int Create_NewOutput_Listener(struct ACNCageServer *server) {
-    server->newOutputListener.notify = New_Output;
+    server->newOutputListener.notify = ACNCAGE_DISPATCH(New_Output);
     wl_signal_add(&server->backend->events.new_output, &server->newOutputListener);
     return 0;
 }
@@ -57,6 +117,7 @@ static void New_Output(struct wl_listener *listener, void *data) {
     // Get the server hosting this newOutputListener
     struct ACNCageServer *server =
         wl_container_of(listener, server, newOutputListener);
+    ACNCageTrace_FirstInstant(&server->trace, "first New_Output");
 
     // Configures the new output to use the server's allocator and renderer
     if (!wlr_output_init_render(wlr_output, server->allocator, server->renderer)) {
@@ -66,57 +127,119 @@ static void New_Output(struct wl_listener *listener, void *data) {
 
     /**
      * Select a output mode for the new output (width x height @ refresh rate)
+     * Every candidate is tested first, so that a bad mode never fails the commit
      * Note: Some backends don't have modes!
      */
-    if (!wl_list_empty(&wlr_output->modes)) {
-        /**
-         * Picking the advertised preferred mode
-         * If there is no preference, the first mode is picked
-         */
-        struct wlr_output_mode *preferredMode =
-            wlr_output_preferred_mode(wlr_output);
-        wlr_log(WLR_INFO, "New wlr_output preferred mode: %d x %d @ %d",
-                preferredMode->width, preferredMode->height, preferredMode->refresh);
-
-        // Modify wlr_output pending state
-        wlr_output_set_mode(wlr_output, preferredMode);  // Set wlr_output_mode
-        wlr_output_enable(wlr_output, true);             // Enable wlr_output
-
-        // Commit wlr_output pending state
-        if (!wlr_output_commit(wlr_output)) {
-            wlr_log(WLR_ERROR, "Failed to commit wlr_output pending state");
-            return;
-        }
+    if (ACNCageOutput_SelectMode(wlr_output, &server->config) != 0) {
+        wlr_log(WLR_ERROR, "Failed to select a mode for wlr_output");
+        return;
+    }
+
+    // Surfaces get laid out, & clients told to render, at this scale
+    wlr_output_set_scale(wlr_output, server->config.scale);
+
+    // Commit wlr_output pending state
+    ACNCageTrace_begin(&server->trace, "output modeset");
+    if (!wlr_output_commit(wlr_output)) {
+        wlr_log(WLR_ERROR, "Failed to commit wlr_output pending state");
+        ACNCageTrace_end(&server->trace, "output modeset");
+        return;
     }
+    ACNCageTrace_end(&server->trace, "output modeset");
 
     // Allocates and initializes a container for the new output
-    struct ACNCageOutput *output = calloc(1, sizeof(struct ACNCageOutput));
+    struct ACNCageOutput *output = ACNCageSlab_alloc(&server->outputSlab);
     if (output == NULL) {
         wlr_log(WLR_ERROR, "Failed to allocate ACNCageOutput");
         return;
     }
     output->wlr_output = wlr_output;
     output->server = server;
+    wlr_output->data = output;
+
+    // Init the frame scheduler of ACNCageOutput
+    if (ACNCageOutput_InitScheduler(output) != 0) {
+        wlr_log(WLR_ERROR, "Failed to init frame scheduler");
+        wlr_output->data = NULL;
+        ACNCageSlab_free(&server->outputSlab, output);
+        return;
+    }
 
     // Create listeners on ACNCageOutput
     if (ACNCageOutput_CreateListeners(output) != 0) {
         wlr_log(WLR_ERROR, "Failed to create listeners");
-        free(output);
+        ACNCageOutput_DestroyScheduler(output);
+        wlr_output->data = NULL;
+        ACNCageSlab_free(&server->outputSlab, output);
         return;
     }
 
     // Register the new output to the server
     wl_list_insert(&server->outputs, &output->link);
 
+    // Mirror mode: the first output gets composited, the others copy it
+    output->mirror = server->config.mirror && server->mirrorPrimary != NULL;
+    if (server->config.mirror && server->mirrorPrimary == NULL) {
+        server->mirrorPrimary = output;
+        // Drawn into the primary's frames, rather than on its cursor plane,
+        // so that the mirrors show the pointer too
+        wlr_output_lock_software_cursors(wlr_output, true);
+    }
+
     /**
      * Add the new output to the output layout
      * Note: Add auto arranges outputs from left-to-right in the order they appear
+     * Note: Mirrors stay out of the layout, so that the scene ignores them
      */
-    wlr_output_layout_add_auto(server->output_layout, wlr_output);
+    if (!output->mirror)
+        wlr_output_layout_add_auto(server->output_layout, wlr_output);
+
+    // Adaptive sync & static refresh, per configuration
+    output->baseMode = wlr_output->current_mode;
+    ACNCageOutput_UpdateRefresh(output);
+
+    // The cursor may need to be drawn at a new scale
+    if (ACNCageServer_LoadCursorTheme(server) != 0)
+        wlr_log(WLR_ERROR, "Failed to load cursor theme");
+}
+
+static int Create_ClientCreated_Listener(struct ACNCageServer *server) {
+    server->clientCreatedListener.notify = ACNCAGE_DISPATCH(Client_Created);
+    wl_display_add_client_created_listener(server->wl_display,
+                                           &server->clientCreatedListener);
+    return 0;
+}
+
+// Raise by the display, when a client connects
+static void Client_Created(struct wl_listener *listener, void *data) {
+    struct ACNCageServer *server =
+        wl_container_of(listener, server, clientCreatedListener);
+    struct wl_client *wl_client = data;  // Cast data to wl_client
+
+    // Accounting is best effort, the client is served regardless
+    if (ACNCageClient_create(server, wl_client) != 0)
+        wlr_log(WLR_ERROR, "Failed to create ACNCageClient");
+}
+
+static int Create_NewSurface_Listener(struct ACNCageServer *server) {
+    server->newSurfaceListener.notify = ACNCAGE_DISPATCH(New_Surface);
+    wl_signal_add(&server->compositor->events.new_surface,
+                  &server->newSurfaceListener);
+    return 0;
+}
+
+// Raise by the compositor, when a client creates a surface
+static void New_Surface(struct wl_listener *listener __attribute__((unused)),
+                        void *data) {
+    struct wlr_surface *surface = data;  // Cast data to wlr_surface
+
+    // Commits get accounted to the surface's client
+    if (ACNCageClient_TrackSurface(surface) != 0)
+        wlr_log(WLR_ERROR, "Failed to track the commits of a surface");
 }
 
 static int Create_NewXdgSurface_Listener(struct ACNCageServer *server) {
-    server->newXdgSurfaceListener.notify = New_XdgSurface;
+    server->newXdgSurfaceListener.notify = ACNCAGE_DISPATCH(New_XdgSurface);
     wl_signal_add(&server->xdg_shell->events.new_surface,
                   &server->newXdgSurfaceListener);
     return 0;
@@ -131,7 +254,11 @@ static void New_XdgSurface(struct wl_listener *listener, void *data) {
         return;
     }
 
-    // Attach the XDG popup to it's parent's scene tree,
+    // Get the server hosting this newXdgSurfaceListener
+    struct ACNCageServer *server =
+        wl_container_of(listener, server, newXdgSurfaceListener);
+
+    // Attach the XDG popup to its parent's scene tree,
     // so that the popup gets rendered
     if (wlr_xdg_surface->role == WLR_XDG_SURFACE_ROLE_POPUP) {
         struct wlr_xdg_surface *parent =
@@ -140,18 +267,30 @@ static void New_XdgSurface(struct wl_listener *listener, void *data) {
 
         wlr_xdg_surface->data =
             wlr_scene_xdg_surface_create(parentSceneTree, wlr_xdg_surface);
-        if (wlr_xdg_surface->data == NULL)
+        if (wlr_xdg_surface->data == NULL) {
             wlr_log(WLR_ERROR, "Failed to attach popup to parent scene tree");
+            return;
+        }
+
+        // Track the popup, so that it invalidates cursor hit-testing
+        struct ACNCagePopup *popup = ACNCageSlab_alloc(&server->popupSlab);
+        if (popup == NULL) {
+            wlr_log(WLR_ERROR, "Failed to allocate ACNCagePopup");
+            return;
+        }
+        popup->wlr_xdg_popup = wlr_xdg_surface->popup;
+        popup->server = server;
+
+        if (ACNCagePopup_CreateListeners(popup) != 0) {
+            wlr_log(WLR_ERROR, "Failed to create listeners");
+            ACNCageSlab_free(&server->popupSlab, popup);
+        }
 
         return;
     }
 
-    // Get the server hosting this newXdgSurfaceListener
-    struct ACNCageServer *server =
-        wl_container_of(listener, server, newXdgSurfaceListener);
-
     // Allocates and initializes a container for the new surface
-    struct ACNCageView *view = calloc(1, sizeof(struct ACNCageView));
+    struct ACNCageView *view = ACNCageSlab_alloc(&server->viewSlab);
     if (view == NULL) {
         wlr_log(WLR_ERROR, "Failed to allocate ACNCageView");
         return;
@@ -165,22 +304,110 @@ static void New_XdgSurface(struct wl_listener *listener, void *data) {
         &server->scene->tree, view->wlr_xdg_toplevel->base);
     if (view->wlr_scene_tree == NULL) {
         wlr_log(WLR_ERROR, "Failed to attach toplevel to server scene tree");
-        free(view);
+        ACNCageSlab_free(&server->viewSlab, view);
         return;
     }
     view->wlr_scene_tree->node.data = view;
     wlr_xdg_surface->data = view->wlr_scene_tree;
 
     // Create listeners on ACNCageView
-    if (ACNCageView_CreateListeners(view, wlr_xdg_surface) != 0) {
+    if (ACNCageView_CreateListeners(view) != 0) {
+        wlr_log(WLR_ERROR, "Failed to create listeners");
+        ACNCageSlab_free(&server->viewSlab, view);
+        return;
+    }
+}
+
+#if WLR_HAS_XWAYLAND
+static int Create_NewXwaylandSurface_Listener(struct ACNCageServer *server) {
+    server->newXwaylandSurfaceListener.notify =
+        ACNCAGE_DISPATCH(New_XwaylandSurface);
+    wl_signal_add(&server->xwayland->events.new_surface,
+                  &server->newXwaylandSurfaceListener);
+    return 0;
+}
+
+// Raise by Xwayland, when an X11 client creates a window
+static void New_XwaylandSurface(struct wl_listener *listener, void *data) {
+    struct wlr_xwayland_surface *wlr_xwayland_surface =
+        data;  // Cast data to wlr_xwayland_surface
+
+    // Get the server hosting this newXwaylandSurfaceListener
+    struct ACNCageServer *server =
+        wl_container_of(listener, server, newXwaylandSurfaceListener);
+
+    // Allocates and initializes a container for the new window
+    struct ACNCageView *view = ACNCageSlab_alloc(&server->viewSlab);
+    if (view == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageView");
+        return;
+    }
+    view->type = ACNCAGE_VIEW_XWAYLAND;
+    view->wlr_xwayland_surface = wlr_xwayland_surface;
+    view->server = server;
+
+    // Unlike an xdg_surface, the window has no surface until mapped
+    // Its tree is attached to the server scene tree now, & filled on map
+    view->wlr_scene_tree = wlr_scene_tree_create(&server->scene->tree);
+    if (view->wlr_scene_tree == NULL) {
+        wlr_log(WLR_ERROR, "Failed to attach X11 window to server scene tree");
+        ACNCageSlab_free(&server->viewSlab, view);
+        return;
+    }
+    wlr_scene_node_set_enabled(&view->wlr_scene_tree->node, false);
+    view->wlr_scene_tree->node.data = view;
+    wlr_xwayland_surface->data = view;
+
+    // Create listeners on ACNCageView
+    if (ACNCageView_CreateListeners(view) != 0) {
         wlr_log(WLR_ERROR, "Failed to create listeners");
-        free(view);
+        wlr_xwayland_surface->data = NULL;
+        wlr_scene_node_destroy(&view->wlr_scene_tree->node);
+        ACNCageSlab_free(&server->viewSlab, view);
+        return;
+    }
+}
+#endif
+
+static int Create_ContentTypeChange_Listener(struct ACNCageServer *server) {
+    server->contentTypeChangeListener.notify = ACNCAGE_DISPATCH(ContentType_Change);
+    wl_signal_add(&server->contentTypeManager->events.change,
+                  &server->contentTypeChangeListener);
+    return 0;
+}
+
+// Raise by the content type manager, when a surface commits a new content type
+static void ContentType_Change(struct wl_listener *listener
+                               __attribute__((unused)),
+                               void *data) {
+    struct wlr_surface *surface = data;  // Cast data to wlr_surface
+
+    // Only fullscreen toplevels drive the refresh policy of their output
+#if WLR_HAS_XWAYLAND
+    if (wlr_surface_is_xwayland_surface(surface)) {
+        struct ACNCageView *view =
+            wlr_xwayland_surface_from_wlr_surface(surface)->data;
+        if (view != NULL && view->fullscreenOutput != NULL)
+            ACNCageOutput_UpdateRefresh(view->fullscreenOutput);
         return;
     }
+#endif
+    if (!wlr_surface_is_xdg_surface(surface)) return;
+    struct wlr_xdg_surface *wlr_xdg_surface =
+        wlr_xdg_surface_from_wlr_surface(surface);
+    if (wlr_xdg_surface == NULL ||
+        wlr_xdg_surface->role != WLR_XDG_SURFACE_ROLE_TOPLEVEL ||
+        wlr_xdg_surface->data == NULL)
+        return;
+
+    struct wlr_scene_tree *sceneTree = wlr_xdg_surface->data;
+    struct ACNCageView *view = sceneTree->node.data;
+    if (view != NULL && view->fullscreenOutput != NULL)
+        ACNCageOutput_UpdateRefresh(view->fullscreenOutput);
 }
 
 static int Create_NewInput_Listener(struct ACNCageServer *server) {
-    server->newInputListener.notify = New_Input;
+    server->newInputListener.notify = ACNCAGE_DISPATCH(New_Input);
     wl_signal_add(&server->backend->events.new_input, &server->newInputListener);
     return 0;
 }
@@ -199,10 +426,26 @@ static void New_Input(struct wl_listener *listener, void *data) {
             New_Keyboard(server, wlr_input_device);
             break;
 
+        case WLR_INPUT_DEVICE_POINTER:
+            // The cursor aggregates pointer devices
+            wlr_cursor_attach_input_device(server->cursor, wlr_input_device);
+
+            // The first pointer needs a cursor theme to be drawn with
+            server->cursorThemeWanted = true;
+            if (ACNCageServer_LoadCursorTheme(server) != 0)
+                wlr_log(WLR_ERROR, "Failed to load cursor theme");
+            break;
+
         default:
             wlr_log(WLR_INFO, "Unknown input device type");
             break;
     }
+
+    // Advertise the seat capabilities to clients
+    uint32_t capabilities = WL_SEAT_CAPABILITY_POINTER;
+    if (!wl_list_empty(&server->keyboards))
+        capabilities |= WL_SEAT_CAPABILITY_KEYBOARD;
+    wlr_seat_set_capabilities(server->seat, capabilities);
 }
 
 static void New_Keyboard(struct ACNCageServer *server,
@@ -211,7 +454,7 @@ static void New_Keyboard(struct ACNCageServer *server,
     wlr_keyboard_set_repeat_info(wlr_keyboard, 25, 600);
 
     // Allocates and initializes a container for the new keyboard
-    struct ACNCageKeyboard *keyboard = calloc(1, sizeof(struct ACNCageKeyboard));
+    struct ACNCageKeyboard *keyboard = ACNCageSlab_alloc(&server->keyboardSlab);
     if (keyboard == NULL) {
         wlr_log(WLR_ERROR, "Failed to allocate ACNCageKeyboard");
         return;
@@ -219,40 +462,26 @@ static void New_Keyboard(struct ACNCageServer *server,
     keyboard->wlr_keyboard = wlr_keyboard;
     keyboard->server = server;
 
-    // Prepare and assign a keymap to the keyboard
-    struct xkb_context *xkb_context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-    if (xkb_context == NULL) {
-        wlr_log(WLR_ERROR, "Failed to create xkb_context");
-        free(keyboard);
-        xkb_context_unref(xkb_context);
-        return;
-    }
-
+    // Assign a keymap to the keyboard
+    // Note: Keyboards w. the same layout share one compiled keymap
     struct xkb_keymap *xkb_keymap =
-        xkb_keymap_new_from_names(xkb_context, NULL, XKB_KEYMAP_COMPILE_NO_FLAGS);
+        ACNCageKeymapCache_get(server->keymapCache, NULL);
     if (xkb_keymap == NULL) {
-        wlr_log(WLR_ERROR, "Failed to create xkb_keymap");
-        free(keyboard);
-        xkb_context_unref(xkb_context);
-        xkb_keymap_unref(xkb_keymap);
+        wlr_log(WLR_ERROR, "Failed to get xkb_keymap");
+        ACNCageSlab_free(&server->keyboardSlab, keyboard);
         return;
     }
 
     if (!wlr_keyboard_set_keymap(wlr_keyboard, xkb_keymap)) {
         wlr_log(WLR_ERROR, "Failed to assign xkb_keymap to wlr_keyboard");
-        free(keyboard);
-        xkb_context_unref(xkb_context);
-        xkb_keymap_unref(xkb_keymap);
+        ACNCageSlab_free(&server->keyboardSlab, keyboard);
         return;
     }
 
-    xkb_context_unref(xkb_context);
-    xkb_keymap_unref(xkb_keymap);
-
     // Create listeners on ACNCageKeyboard
     if (ACNCageKeyboard_CreateListeners(keyboard, device) != 0) {
         wlr_log(WLR_ERROR, "Failed to create listeners");
-        free(keyboard);
+        ACNCageSlab_free(&server->keyboardSlab, keyboard);
         return;
     }
 
@@ -1,47 +1,155 @@
 #include "server.h"
 
+#include <signal.h>  // SIGINT, SIGTERM, SIGUSR1
+#include <stdlib.h>  // setenv
+#include <unistd.h>  // close
+
+#include <wlr/config.h>    // WLR_HAS_XWAYLAND, WLR_HAS_*_BACKEND
 #include <wlr/util/log.h>  // wlr_log
 
-#include <wlr/types/wlr_xdg_shell.h>  // wlr_xdg_shell
+#include <wlr/types/wlr_buffer.h>            // wlr_buffer_unlock
+#include <wlr/types/wlr_cursor.h>            // wlr_cursor
+#include <wlr/types/wlr_seat.h>              // wlr_seat
+#include <wlr/types/wlr_xcursor_manager.h>  // wlr_xcursor_manager
+#include <wlr/types/wlr_xdg_shell.h>         // wlr_xdg_shell
+
+#include "client.h"           // ACNCageClient_LogStats
+#include "contenttype.h"      // ACNCageContentTypeManager_create
+#include "cursor.h"           // ACNCageServer_LogCursorStats
+#include "dispatch.h"         // ACNCageDispatch_init, ACNCageDispatch_log
+#include "fractionalscale.h"  // ACNCageFractionalScaleManager_create
+#include "keyboard.h"         // ACNCageKeymapCache, ACNCageKeyboard
+#include "launch.h"           // ACNCageLaunch_spawn, ACNCageLaunch_destroy
+#include "output.h"           // ACNCageOutput
+#include "popup.h"            // ACNCagePopup
+#include "render.h"           // ACNCageRender_CreateRenderer
+#include "tearing.h"          // ACNCageTearingManager_create
+#include "trace.h"            // ACNCageTrace_begin, ACNCageTrace_end
+#include "view.h"             // ACNCageView
 
 // Interfaces
-#include <wlr/types/wlr_compositor.h>     // wlr_compositor_create
-#include <wlr/types/wlr_subcompositor.h>  // wlr_subcompositor_create
-#include <wlr/types/wlr_data_device.h>    // wlr_data_device_manager_create
+#include <wlr/types/wlr_compositor.h>              // wlr_compositor_create
+#include <wlr/types/wlr_subcompositor.h>           // wlr_subcompositor_create
+#include <wlr/types/wlr_data_device.h>             // wlr_data_device_manager_create
+#include <wlr/types/wlr_presentation_time.h>       // wlr_presentation_create
+#include <wlr/types/wlr_screencopy_v1.h>           // ..._manager_v1_create
+#include <wlr/types/wlr_single_pixel_buffer_v1.h>  // ..._manager_v1_create
+#include <wlr/types/wlr_viewporter.h>              // wlr_viewporter_create
+#if WLR_HAS_XWAYLAND
+#include <wlr/xwayland.h>  // wlr_xwayland_create
+#endif
+
+// Backends
+#include <wlr/backend/headless.h>  // wlr_headless_backend_create
+#include <wlr/backend/wayland.h>   // wlr_wl_backend_create
+#if WLR_HAS_X11_BACKEND
+#include <wlr/backend/x11.h>  // wlr_x11_backend_create
+#endif
+#if WLR_HAS_DRM_BACKEND
+#include <wlr/backend/drm.h>      // wlr_drm_backend_create
+#include <wlr/backend/multi.h>    // wlr_multi_backend_create
+#include <wlr/backend/session.h>  // wlr_session_create
+#endif
+#if WLR_HAS_LIBINPUT_BACKEND
+#include <wlr/backend/libinput.h>  // wlr_libinput_backend_create
+#endif
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Launch_App(struct ACNCageServer* server);
+static struct wlr_backend* Create_Backend(struct ACNCageServer* server);
+static struct wlr_backend* Create_DrmBackend(struct ACNCageServer* server);
+static struct wlr_renderer* Create_Renderer(struct ACNCageServer* server);
+
+/** Signals **/
+static int Signal_Terminate(int signal, void* data);
+static int Signal_LogStats(int signal, void* data);
+
+/****************************************/
 
 int ACNCageServer_init(struct ACNCageServer* server) {
     if (server == NULL) return -1;
 
+    // Picked once, as listeners register w. or without timing from here on
+    ACNCageDispatch_init(server->config.dispatchTiming,
+                         server->config.dispatchBudgetUs);
+
+    // Views, popups, outputs & keyboards come & go w. clients and devices
+    // Pooling them keeps that churn off the heap
+    // Note: Only our trackers are pooled, their scene nodes are allocated by
+    // wlroots (wlr_scene_xdg_surface_create) which takes no allocator
+    ACNCageSlab_init(&server->viewSlab, "view", sizeof(struct ACNCageView), 16);
+    ACNCageSlab_init(&server->popupSlab, "popup", sizeof(struct ACNCagePopup), 32);
+    ACNCageSlab_init(&server->outputSlab, "output", sizeof(struct ACNCageOutput), 4);
+    ACNCageSlab_init(&server->keyboardSlab, "keyboard",
+                     sizeof(struct ACNCageKeyboard), 4);
+
+    ACNCageTrace_begin(&server->trace, "ACNCageSlab_prewarm");
+    uint64_t prewarm = server->config.slabPrewarm;
+    if (ACNCageSlab_prewarm(&server->viewSlab, prewarm) != 0 ||
+        ACNCageSlab_prewarm(&server->popupSlab, prewarm) != 0 ||
+        ACNCageSlab_prewarm(&server->outputSlab, prewarm) != 0 ||
+        ACNCageSlab_prewarm(&server->keyboardSlab, prewarm) != 0) {
+        wlr_log(WLR_ERROR, "Failed to prewarm object pools");
+        return -1;
+    }
+    ACNCageTrace_end(&server->trace, "ACNCageSlab_prewarm");
+
     server->wl_display = wl_display_create();
     if (server->wl_display == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wl_display");
         return -1;
     }
 
-    server->backend = wlr_backend_autocreate(server->wl_display);
+    // Listen for clients before anything slow (backend, renderer, modeset)
+    // Clients get accepted once the event loop runs, w. every global in place
+    // Note: Only exported once started, a nested backend still needs its parent's
+    server->socket = wl_display_add_socket_auto(server->wl_display);
+    if (server->socket == NULL) {
+        wlr_log(WLR_ERROR, "Failed to open a Wayland socket");
+        return -1;
+    }
+
+    // The app starts up alongside the compositor, until its first roundtrip
+    // Note: Deferred to Xwayland's creation if enabled, for DISPLAY to be set
+    bool xwayland = WLR_HAS_XWAYLAND && server->config.xwayland;
+    if (!xwayland && Launch_App(server) != 0) return -1;
+
+    // Named by config, or probed by wlroots
+    ACNCageTrace_begin(&server->trace, "Create_Backend");
+    server->backend = Create_Backend(server);
     if (server->backend == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_backend");
         return -1;
     }
+    ACNCageTrace_end(&server->trace, "Create_Backend");
 
-    server->renderer = wlr_renderer_autocreate(server->backend);
+    ACNCageTrace_begin(&server->trace, "Create_Renderer");
+    server->renderer = Create_Renderer(server);
     if (server->renderer == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_renderer");
         return -1;
     }
+    ACNCageTrace_end(&server->trace, "Create_Renderer");
 
+    ACNCageTrace_begin(&server->trace, "wlr_renderer_init_wl_display");
     if (!wlr_renderer_init_wl_display(server->renderer, server->wl_display)) {
         wlr_log(WLR_ERROR, "Failed to init wlr_renderer");
         return -1;
     }
+    ACNCageTrace_end(&server->trace, "wlr_renderer_init_wl_display");
 
     // wlr_allocator handles buffer allocation
     // Which then bridges the backend and the renderer
+    // Note: Picked from their buffer capabilities, wlroots keeps the others private
+    ACNCageTrace_begin(&server->trace, "wlr_allocator_autocreate");
     server->allocator = wlr_allocator_autocreate(server->backend, server->renderer);
     if (server->allocator == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_allocator");
         return -1;
     }
+    ACNCageTrace_end(&server->trace, "wlr_allocator_autocreate");
 
     // Helper to arrange outputs in a 2D coordinate space
     server->output_layout = wlr_output_layout_create();
@@ -51,6 +159,14 @@ int ACNCageServer_init(struct ACNCageServer* server) {
     }
 
     // Abstraction that handles all rendering and dmg tracking
+    // Note: A lone fullscreen buffer is scanned out directly, unless disabled
+    if (!server->config.directScanout)
+        setenv("WLR_SCENE_DISABLE_DIRECT_SCANOUT", "1", true);
+    // Note: Damage visualisation is left to wlroots' own debug mode
+    if (server->config.damageDebug == ACNCAGE_DAMAGE_DEBUG_RERENDER)
+        setenv("WLR_SCENE_DEBUG_DAMAGE", "rerender", true);
+    else if (server->config.damageDebug == ACNCAGE_DAMAGE_DEBUG_HIGHLIGHT)
+        setenv("WLR_SCENE_DEBUG_DAMAGE", "highlight", true);
     server->scene = wlr_scene_create();
     if (server->scene == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_scene");
@@ -79,15 +195,12 @@ int ACNCageServer_init(struct ACNCageServer* server) {
 
     // wlr_xcursor_manager is a wlroots utility, which loads xcursor themes
     // For the compositor to source cursor images from
+    // Note: Themes are loaded on demand, once a pointer device shows up
     server->xcursor_manager = wlr_xcursor_manager_create(NULL, 24);
     if (server->xcursor_manager == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_xcursor_manager");
         return -1;
     }
-    if (!wlr_xcursor_manager_load(server->xcursor_manager, 1)) {
-        wlr_log(WLR_ERROR, "Failed to load xcursor themes");
-        return -1;
-    }
 
     // wlr_seat is an abstraction on top of wl_seat, which provides an abstraction
     // over input events on Wayland
@@ -97,12 +210,50 @@ int ACNCageServer_init(struct ACNCageServer* server) {
         return -1;
     }
 
+    // Keymaps are compiled once, then shared by every keyboard w. the same layout
+    ACNCageTrace_begin(&server->trace, "ACNCageKeymapCache_create");
+    server->keymapCache = ACNCageKeymapCache_create(server->config.keymapCacheDir);
+    if (server->keymapCache == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create keymap cache");
+        return -1;
+    }
+    ACNCageTrace_end(&server->trace, "ACNCageKeymapCache_create");
+
     return 0;
 }
 
 void ACNCageServer_destroy(struct ACNCageServer* server) {
     if (server == NULL) return;
 
+    if (server->cursor != NULL) ACNCageServer_LogCursorStats(server);
+
+#if WLR_HAS_XWAYLAND
+    // Takes its X11 windows w. it
+    if (server->xwayland != NULL) {
+        wl_list_remove(&server->newXwaylandSurfaceListener.link);
+        wlr_xwayland_destroy(server->xwayland);
+        server->xwayland = NULL;
+    }
+#endif
+
+    // Clients go first, while everything they refer to is still around
+    if (server->wl_display != NULL) wl_display_destroy_clients(server->wl_display);
+
+    for (int i = 0; i < 2; ++i) {
+        if (server->terminateSources[i] != NULL)
+            wl_event_source_remove(server->terminateSources[i]);
+    }
+    if (server->statsSource != NULL) wl_event_source_remove(server->statsSource);
+    ACNCageLaunch_destroy(server->launch);
+    server->launch = NULL;
+
+    // Outputs going away w. the backend mustn't promote a mirror
+    if (server->mirrorBuffer != NULL) wlr_buffer_unlock(server->mirrorBuffer);
+    server->mirrorBuffer = NULL;
+    server->mirrorPrimary = NULL;
+
+    if (server->keymapCache != NULL) ACNCageKeymapCache_destroy(server->keymapCache);
+
     if (server->seat != NULL) wlr_seat_destroy(server->seat);
 
     if (server->xcursor_manager != NULL)
@@ -119,12 +270,31 @@ void ACNCageServer_destroy(struct ACNCageServer* server) {
 
     if (server->backend != NULL) wlr_backend_destroy(server->backend);
 
+#if WLR_HAS_DRM_BACKEND
+    if (server->session != NULL) wlr_session_destroy(server->session);
+#endif
+
     if (server->wl_display != NULL) wl_display_destroy(server->wl_display);
+
+    // Pooled objects are released by the display & backend teardown above
+    ACNCageSlab_log(&server->viewSlab);
+    ACNCageSlab_log(&server->popupSlab);
+    ACNCageSlab_log(&server->outputSlab);
+    ACNCageSlab_log(&server->keyboardSlab);
+    ACNCageSlab_finish(&server->viewSlab);
+    ACNCageSlab_finish(&server->popupSlab);
+    ACNCageSlab_finish(&server->outputSlab);
+    ACNCageSlab_finish(&server->keyboardSlab);
+    ACNCageDispatch_log();
+
+    // Written out now, if startup never completed
+    ACNCageTrace_finish(&server->trace);
 }
 
 int ACNCageServer_CreateInterfaces(struct ACNCageServer* server) {
     // wlr_compositor provides surface allocation
-    if (wlr_compositor_create(server->wl_display, server->renderer) == NULL) {
+    server->compositor = wlr_compositor_create(server->wl_display, server->renderer);
+    if (server->compositor == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_compositor");
         return -1;
     }
@@ -135,11 +305,287 @@ int ACNCageServer_CreateInterfaces(struct ACNCageServer* server) {
         return -1;
     }
 
+    // wp_presentation tells clients when & how their frames reached the screen
+    // The scene-graph feeds it from every output's present events
+    server->presentation =
+        wlr_presentation_create(server->wl_display, server->backend);
+    if (server->presentation == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wlr_presentation");
+        return -1;
+    }
+    wlr_scene_set_presentation(server->scene, server->presentation);
+
+    // wp_content_type_v1 lets clients hint at what their surfaces display
+    server->contentTypeManager =
+        ACNCageContentTypeManager_create(server->wl_display);
+    if (server->contentTypeManager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wp_content_type_manager_v1");
+        return -1;
+    }
+
+    // wp_tearing_control_v1 lets clients trade tear-free output for latency
+    server->tearingManager = ACNCageTearingManager_create(server->wl_display);
+    if (server->tearingManager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wp_tearing_control_manager_v1");
+        return -1;
+    }
+
+    // wp_viewporter lets clients render at a lower (or fractional) resolution
+    // & have their buffers cropped / scaled to the surface size
+    if (wlr_viewporter_create(server->wl_display) == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wlr_viewporter");
+        return -1;
+    }
+
+    // wp_fractional_scale_v1 tells clients which scale to render at
+    // Together w. wp_viewporter, no more rendering at 2x to show at 1.25x
+    server->fractionalScaleManager =
+        ACNCageFractionalScaleManager_create(server->wl_display);
+    if (server->fractionalScaleManager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wp_fractional_scale_manager_v1");
+        return -1;
+    }
+
+    // wp_single_pixel_buffer_v1 lets solid colour surfaces (backgrounds,
+    // letterboxing) skip allocating & uploading a full size buffer
+    if (wlr_single_pixel_buffer_manager_v1_create(server->wl_display) == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wlr_single_pixel_buffer_manager_v1");
+        return -1;
+    }
+
+    // wlr_screencopy_manager_v1 lets local tools capture outputs
+    // Note: Damage comes from the scene's per-output damage (output commits), so
+    // that damage-tracked captures only copy & send what changed
+    if (server->config.screencopy != ACNCAGE_SCREENCOPY_OFF) {
+        server->screencopyManager =
+            wlr_screencopy_manager_v1_create(server->wl_display);
+        if (server->screencopyManager == NULL) {
+            wlr_log(WLR_ERROR, "Failed to create wlr_screencopy_manager_v1");
+            return -1;
+        }
+    }
+
     // wlr_data_device_manager handles the clipboard
     if (wlr_data_device_manager_create(server->wl_display) == NULL) {
         wlr_log(WLR_ERROR, "Failed to create wlr_data_device_manager");
         return -1;
     }
 
+#if WLR_HAS_XWAYLAND
+    // Xwayland runs X11 clients as Wayland surfaces
+    // Note: Lazy, only the X11 socket is opened (& exported as DISPLAY) here,
+    // the server starts w. the first X11 client, if any ever connects
+    if (server->config.xwayland) {
+        server->xwayland =
+            wlr_xwayland_create(server->wl_display, server->compositor, true);
+        if (server->xwayland == NULL) {
+            wlr_log(WLR_ERROR, "Failed to create wlr_xwayland");
+            return -1;
+        }
+        wlr_xwayland_set_seat(server->xwayland, server->seat);
+
+        // Removable on destroy, even if startup fails before listeners are created
+        wl_list_init(&server->newXwaylandSurfaceListener.link);
+
+        if (setenv("DISPLAY", server->xwayland->display_name, true) != 0) {
+            wlr_log(WLR_ERROR, "Failed to set DISPLAY");
+            return -1;
+        }
+    }
+#endif
+
+    // Unless already launched, from ACNCageServer_init
+    if (Launch_App(server) != 0) return -1;
+
+    return 0;
+}
+
+int ACNCageServer_start(struct ACNCageServer* server) {
+    struct wl_event_loop* loop = wl_display_get_event_loop(server->wl_display);
+
+    // Handled from the event loop, never from an arbitrary point of execution
+    server->terminateSources[0] =
+        wl_event_loop_add_signal(loop, SIGINT, Signal_Terminate, server);
+    server->terminateSources[1] =
+        wl_event_loop_add_signal(loop, SIGTERM, Signal_Terminate, server);
+    server->statsSource =
+        wl_event_loop_add_signal(loop, SIGUSR1, Signal_LogStats, server);
+    if (server->terminateSources[0] == NULL || server->terminateSources[1] == NULL ||
+        server->statsSource == NULL) {
+        wlr_log(WLR_ERROR, "Failed to add signal handlers");
+        return -1;
+    }
+
+    // Clients spawned from here connect to this compositor
+    if (setenv("WAYLAND_DISPLAY", server->socket, true) != 0) {
+        wlr_log(WLR_ERROR, "Failed to set WAYLAND_DISPLAY");
+        return -1;
+    }
+
+    ACNCageTrace_begin(&server->trace, "wlr_backend_start");
+    if (!wlr_backend_start(server->backend)) {
+        wlr_log(WLR_ERROR, "Failed to start wlr_backend");
+        ACNCageTrace_end(&server->trace, "wlr_backend_start");
+        return -1;
+    }
+    ACNCageTrace_end(&server->trace, "wlr_backend_start");
+
+    wlr_log(WLR_INFO, "Running on WAYLAND_DISPLAY=%s", server->socket);
+    return 0;
+}
+
+void ACNCageServer_LogStats(struct ACNCageServer* server) {
+    ACNCageServer_LogCursorStats(server);
+
+    ACNCageSlab_log(&server->viewSlab);
+    ACNCageSlab_log(&server->popupSlab);
+    ACNCageSlab_log(&server->outputSlab);
+    ACNCageSlab_log(&server->keyboardSlab);
+
+    ACNCageDispatch_log();
+
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) ACNCageOutput_LogStats(output);
+
+    struct ACNCageClient* client;
+    wl_list_for_each(client, &server->clients, link) ACNCageClient_LogStats(client);
+}
+
+static int Launch_App(struct ACNCageServer* server) {
+    if (server->appArgv == NULL || server->launch != NULL) return 0;
+
+    ACNCageTrace_begin(&server->trace, "ACNCageLaunch_spawn");
+    server->launch = ACNCageLaunch_spawn(server->wl_display, server->socket,
+                                         server->appArgv, server->startNsec);
+    ACNCageTrace_end(&server->trace, "ACNCageLaunch_spawn");
+    if (server->launch == NULL) {
+        wlr_log(WLR_ERROR, "Failed to launch %s", server->appArgv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+static struct wlr_backend* Create_Backend(struct ACNCageServer* server) {
+    struct wl_display* display = server->wl_display;
+    const struct ACNCageConfig* config = &server->config;
+
+    struct wlr_backend* backend = NULL;
+    switch (config->backend) {
+        case ACNCAGE_BACKEND_AUTO:
+            return wlr_backend_autocreate(display);
+        case ACNCAGE_BACKEND_DRM:
+            return Create_DrmBackend(server);
+        case ACNCAGE_BACKEND_HEADLESS: {
+            // A single output, of the configured mode's size
+            int width = config->mode.width > 0 ? config->mode.width : 1920;
+            int height = config->mode.height > 0 ? config->mode.height : 1080;
+            backend = wlr_headless_backend_create(display);
+            if (backend != NULL &&
+                wlr_headless_add_output(backend, width, height) == NULL) {
+                wlr_backend_destroy(backend);
+                return NULL;
+            }
+            return backend;
+        }
+        case ACNCAGE_BACKEND_WAYLAND:
+            // Note: Outputs requested before the start are created by it
+            backend = wlr_wl_backend_create(display, NULL);
+            if (backend != NULL) wlr_wl_output_create(backend);
+            return backend;
+        case ACNCAGE_BACKEND_X11:
+#if WLR_HAS_X11_BACKEND
+            backend = wlr_x11_backend_create(display, NULL);
+            if (backend != NULL) wlr_x11_output_create(backend);
+            return backend;
+#else
+            wlr_log(WLR_ERROR, "wlroots was built without the X11 backend");
+            return NULL;
+#endif
+    }
+    return NULL;
+}
+
+// DRM/KMS outputs & libinput devices, w. a session (seat) to open them
+static struct wlr_backend* Create_DrmBackend(struct ACNCageServer* server) {
+#if WLR_HAS_DRM_BACKEND
+    struct wl_display* display = server->wl_display;
+
+    server->session = wlr_session_create(display);
+    if (server->session == NULL) {
+        wlr_log(WLR_ERROR, "Failed to create wlr_session");
+        return NULL;
+    }
+
+    // Named device, or the boot GPU
+    struct wlr_device* device = NULL;
+    if (server->config.drmDevice != NULL)
+        device = wlr_session_open_file(server->session, server->config.drmDevice);
+    else if (wlr_session_find_gpus(server->session, 1, &device) < 1)
+        device = NULL;
+    if (device == NULL) {
+        wlr_log(WLR_ERROR, "Failed to open a DRM device");
+        return NULL;
+    }
+
+    struct wlr_backend* backend = wlr_multi_backend_create(display);
+    if (backend == NULL) return NULL;
+
+    struct wlr_backend* drm =
+        wlr_drm_backend_create(display, server->session, device, NULL);
+    if (drm == NULL || !wlr_multi_backend_add(backend, drm)) {
+        if (drm != NULL) wlr_backend_destroy(drm);
+        wlr_backend_destroy(backend);
+        return NULL;
+    }
+
+#if WLR_HAS_LIBINPUT_BACKEND
+    struct wlr_backend* libinput =
+        wlr_libinput_backend_create(display, server->session);
+    if (libinput == NULL || !wlr_multi_backend_add(backend, libinput)) {
+        if (libinput != NULL) wlr_backend_destroy(libinput);
+        wlr_backend_destroy(backend);
+        return NULL;
+    }
+#else
+    wlr_log(WLR_INFO, "wlroots was built without libinput, no input devices");
+#endif
+    return backend;
+#else
+    (void)server;
+    wlr_log(WLR_ERROR, "wlroots was built without the DRM backend");
+    return NULL;
+#endif
+}
+
+static struct wlr_renderer* Create_Renderer(struct ACNCageServer* server) {
+    enum ACNCageRenderer renderer = server->config.renderer;
+    if (renderer == ACNCAGE_RENDERER_AUTO)
+        return wlr_renderer_autocreate(server->backend);
+
+    // The backend's device, or a render node (headless)
+    int drmFd = wlr_backend_get_drm_fd(server->backend);
+    int renderNodeFd = -1;
+    if (drmFd < 0 && renderer != ACNCAGE_RENDERER_PIXMAN)
+        drmFd = renderNodeFd =
+            ACNCageRender_OpenRenderNode(server->config.drmDevice);
+
+    struct wlr_renderer* wlr_renderer =
+        ACNCageRender_CreateRenderer(renderer, drmFd);
+    if (renderNodeFd != -1) close(renderNodeFd);
+    return wlr_renderer;
+}
+
+// Raise by the event loop, on SIGINT & SIGTERM
+static int Signal_Terminate(int signal, void* data) {
+    struct ACNCageServer* server = data;
+    wlr_log(WLR_INFO, "Received signal %d, terminating", signal);
+    wl_display_terminate(server->wl_display);
+    return 0;
+}
+
+// Raise by the event loop, on SIGUSR1
+static int Signal_LogStats(int signal __attribute__((unused)), void* data) {
+    struct ACNCageServer* server = data;
+    ACNCageServer_LogStats(server);
     return 0;
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint32_t, uint64_t
+
 #include <wayland-server-core.h>  // wl_display
 
 #include <wlr/backend.h>                  // wlr_backend
@@ -7,24 +10,82 @@
 #include <wlr/render/allocator.h>         // wlr_allocator
 #include <wlr/types/wlr_output_layout.h>  // wlr_output_layout
 #include <wlr/types/wlr_scene.h>          // wlr_scene
+#include <wlr/util/box.h>                 // wlr_box
+
+#include "config.h"   // ACNCageConfig
+#include "latency.h"  // ACNCageInputStamp
+#include "slab.h"     // ACNCageSlab
+#include "trace.h"    // ACNCageTrace
+
+// Last surface found under the cursor, valid for a single scene generation
+struct ACNCageHitCache {
+    uint64_t generation;
+    struct wlr_surface* surface;  // NULL if empty
+    struct ACNCageView* view;
+    struct wlr_box box;  // Surface, in layout coordinates
+    struct wl_listener surfaceDestroyListener;
+
+    uint64_t hits;
+    uint64_t misses;
+};
 
 struct ACNCageServer {
+    // Configuration
+    struct ACNCageConfig config;
+
+    // Startup timeline
+    struct ACNCageTrace trace;
+
+    // Object pools
+    struct ACNCageSlab viewSlab;
+    struct ACNCageSlab popupSlab;
+    struct ACNCageSlab outputSlab;
+    struct ACNCageSlab keyboardSlab;
+
     // Resources
     struct wl_display* wl_display;
     struct wlr_backend* backend;
     struct wlr_renderer* renderer;
     struct wlr_allocator* allocator;
+    struct wlr_session* session;  // DRM backend's, NULL otherwise
     struct wlr_output_layout* output_layout;
     struct wlr_scene* scene;
+    struct wlr_compositor* compositor;
 
     // Outputs
     struct wl_list outputs;
     struct wl_listener newOutputListener;
 
+    // Mirror mode
+    struct ACNCageOutput* mirrorPrimary;  // Only output composited, NULL if none
+    struct wlr_buffer* mirrorBuffer;      // Last frame of the primary, locked
+    uint64_t mirrorSeq;                   // Bumped w. every new mirrorBuffer
+
+    // Presentation feedback
+    struct wlr_presentation* presentation;
+
+    // Screen capture, NULL if disabled
+    struct wlr_screencopy_manager_v1* screencopyManager;
+
+    // Surface hints
+    struct ACNCageContentTypeManager* contentTypeManager;
+    struct wl_listener contentTypeChangeListener;
+    struct ACNCageTearingManager* tearingManager;
+    struct ACNCageFractionalScaleManager* fractionalScaleManager;
+    uint64_t fractionalScaleGeneration;  // Scene generation last sent scales for
+
+    // Clients
+    struct wl_list clients;  // ACNCageClient.link
+    struct wl_listener clientCreatedListener;
+    struct wl_listener newSurfaceListener;  // Commit accounting
+
     // Shells
     struct wl_list views;
     struct wlr_xdg_shell* xdg_shell;
     struct wl_listener newXdgSurfaceListener;
+    struct wlr_xwayland* xwayland;  // NULL if disabled, or not built in
+    struct wl_listener newXwaylandSurfaceListener;
+    uint64_t sceneGeneration;  // Bumped on (un)map, destroy, move, restack & resize
 
     // Cursor
     struct wlr_cursor* cursor;
@@ -34,17 +95,38 @@ struct ACNCageServer {
     struct wl_listener cursorButtonListener;
     struct wl_listener cursorAxisListener;
     struct wl_listener cursorFrameListener;
+    bool cursorMotionQueued;  // Coalesced motion, waiting to be processed
+    uint32_t cursorMotionTime;
+    struct ACNCageHitCache hitCache;
+    bool cursorThemeWanted;   // A pointer device has shown up
+    const char* cursorImage;  // Image set by the compositor, NULL if none
 
     // Keyboard
     struct wl_list keyboards;
+    struct ACNCageKeymapCache* keymapCache;
 
     // Seat
     struct wlr_seat* seat;
     struct wl_listener newInputListener;
+
+    // Input-to-photon latency
+    struct ACNCageInputStamp inputStamp;
+
+    // Kiosk app, set before init
+    char* const* appArgv;          // Command to launch, NULL if none
+    int64_t startNsec;             // Compositor startup, monotonic clock
+    struct ACNCageLaunch* launch;  // NULL until launched, or if none
+
+    // Event loop
+    const char* socket;                           // Wayland socket, once init
+    struct wl_event_source* terminateSources[2];  // SIGINT, SIGTERM
+    struct wl_event_source* statsSource;          // SIGUSR1
 };
 
 /**
  * Inits the provided ACNCageServer
+ * Note: Opens the Wayland socket right away, & launches the app as soon as it
+ * has all it needs to connect
  * :param server: server to init
  * :return: Success 0, Error -1
  */
@@ -69,3 +151,18 @@ int ACNCageServer_CreateInterfaces(struct ACNCageServer* server);
  * :return: Success 0, Error -1
  */
 int ACNCageServer_CreateListeners(struct ACNCageServer* server);
+
+/**
+ * Export the Wayland socket as WAYLAND_DISPLAY, hook SIGINT & SIGTERM to end the
+ * event loop & SIGUSR1 to dump statistics, then start the backend
+ * :param server: server to start
+ * :return: Success 0, Error -1
+ */
+int ACNCageServer_start(struct ACNCageServer* server);
+
+/**
+ * Log the statistics of the provided ACNCageServer: cursor, object pools,
+ * outputs & clients
+ * :param server: server to report on
+ */
+void ACNCageServer_LogStats(struct ACNCageServer* server);
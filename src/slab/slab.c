@@ -0,0 +1,107 @@
+#include "slab.h"
+
+#include <inttypes.h>  // PRIu64
+#include <stdalign.h>  // alignof
+#include <stdlib.h>    // malloc, free
+#include <string.h>    // memset
+
+#include <wlr/util/log.h>  // wlr_log
+
+// Header of a chunk, objects follow it
+struct ACNCageSlabChunk {
+    struct ACNCageSlabChunk* next;
+    alignas(max_align_t) unsigned char objects[];
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static int Grow_Slab(struct ACNCageSlab* slab);
+
+/****************************************/
+
+void ACNCageSlab_init(struct ACNCageSlab* slab, const char* name, size_t objectSize,
+                      size_t objectsPerChunk) {
+    // Each object must hold a free list link, & keep the next one aligned
+    size_t align = alignof(max_align_t);
+    if (objectSize < sizeof(void*)) objectSize = sizeof(void*);
+    objectSize = (objectSize + align - 1) / align * align;
+
+    *slab = (struct ACNCageSlab){
+        .name = name,
+        .objectSize = objectSize,
+        .objectsPerChunk = objectsPerChunk > 0 ? objectsPerChunk : 1,
+    };
+}
+
+void ACNCageSlab_finish(struct ACNCageSlab* slab) {
+    if (slab->live != 0)
+        wlr_log(WLR_DEBUG, "Slab %s: releasing %" PRIu64 " live objects", slab->name,
+                slab->live);
+
+    struct ACNCageSlabChunk* chunk = slab->chunks;
+    while (chunk != NULL) {
+        struct ACNCageSlabChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    slab->chunks = NULL;
+    slab->freeList = NULL;
+    slab->capacity = 0;
+    slab->live = 0;
+}
+
+int ACNCageSlab_prewarm(struct ACNCageSlab* slab, uint64_t count) {
+    while (slab->capacity < count)
+        if (Grow_Slab(slab) != 0) return -1;
+    return 0;
+}
+
+void* ACNCageSlab_alloc(struct ACNCageSlab* slab) {
+    if (slab->freeList == NULL && Grow_Slab(slab) != 0) return NULL;
+
+    void* object = slab->freeList;
+    slab->freeList = *(void**)object;
+
+    slab->live++;
+    if (slab->live > slab->peak) slab->peak = slab->live;
+
+    memset(object, 0, slab->objectSize);
+    return object;
+}
+
+void ACNCageSlab_free(struct ACNCageSlab* slab, void* object) {
+    if (object == NULL) return;
+
+    *(void**)object = slab->freeList;
+    slab->freeList = object;
+    slab->live--;
+}
+
+void ACNCageSlab_log(const struct ACNCageSlab* slab) {
+    wlr_log(WLR_INFO,
+            "Slab %s: %" PRIu64 " live, %" PRIu64 " peak, %" PRIu64 " capacity",
+            slab->name, slab->live, slab->peak, slab->capacity);
+}
+
+static int Grow_Slab(struct ACNCageSlab* slab) {
+    struct ACNCageSlabChunk* chunk = malloc(
+        sizeof(struct ACNCageSlabChunk) + slab->objectSize * slab->objectsPerChunk);
+    if (chunk == NULL) {
+        wlr_log(WLR_ERROR, "Failed to grow slab %s", slab->name);
+        return -1;
+    }
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+
+    // Thread the new objects onto the free list, in address order
+    for (size_t i = slab->objectsPerChunk; i > 0; i--) {
+        void* object = chunk->objects + (i - 1) * slab->objectSize;
+        *(void**)object = slab->freeList;
+        slab->freeList = object;
+    }
+    slab->capacity += slab->objectsPerChunk;
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint64_t
+
+// Fixed-size object pool, carving objects of a single type out of chunks
+// Freed objects are kept on a free list for reuse, & never given back to the heap
+struct ACNCageSlab {
+    const char* name;       // Type name, for statistics
+    size_t objectSize;      // Rounded up to max_align_t
+    size_t objectsPerChunk;
+
+    struct ACNCageSlabChunk* chunks;  // Every chunk allocated, freed on finish
+    void* freeList;                   // Free objects, linked through their 1st word
+
+    uint64_t capacity;  // Objects carved out of chunks
+    uint64_t live;      // Objects handed out
+    uint64_t peak;      // Highest live count
+};
+
+/**
+ * Init the provided slab, for objects of the provided size
+ * :param            slab: slab to init
+ * :param            name: type name, for statistics
+ * :param      objectSize: size of an object
+ * :param objectsPerChunk: objects carved out of each heap allocation
+ */
+void ACNCageSlab_init(struct ACNCageSlab* slab, const char* name, size_t objectSize,
+                      size_t objectsPerChunk);
+
+/**
+ * Release every chunk of the provided slab
+ * Note: Objects still live are released as well
+ * :param slab: slab to finish
+ */
+void ACNCageSlab_finish(struct ACNCageSlab* slab);
+
+/**
+ * Grow the provided slab, until it holds at least the provided object count
+ * :param  slab: slab to grow
+ * :param count: object count to hold
+ * :return: Success 0, Error -1
+ */
+int ACNCageSlab_prewarm(struct ACNCageSlab* slab, uint64_t count);
+
+/**
+ * Take a zeroed object from the provided slab, growing it if empty
+ * :param slab: slab to take from
+ * :return: Success the object, Error NULL
+ */
+void* ACNCageSlab_alloc(struct ACNCageSlab* slab);
+
+/**
+ * Give an object back to the slab it was taken from
+ * :param   slab: slab to give back to
+ * :param object: object to give back, NULL is ignored
+ */
+void ACNCageSlab_free(struct ACNCageSlab* slab, void* object);
+
+/**
+ * Log live, peak & capacity object counts of the provided slab
+ * :param slab: slab to log
+ */
+void ACNCageSlab_log(const struct ACNCageSlab* slab);
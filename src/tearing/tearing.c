@@ -0,0 +1,205 @@
+#include "tearing.h"
+
+#include <stdlib.h>  // calloc, free
+
+#include <wlr/util/addon.h>  // wlr_addon
+#include <wlr/util/log.h>    // wlr_log
+
+#include "dispatch.h"                      // ACNCAGE_DISPATCH
+#include "tearing-control-v1-protocol.h"  // wp_tearing_control_*_v1
+
+#define TEARING_MANAGER_VERSION 1
+
+// Tearing control object of a surface, double-buffered like the surface state
+struct ACNCageTearingSurface {
+    struct wl_resource* resource;  // NULL once destroyed by the client
+    struct wlr_surface* surface;
+    struct wlr_addon addon;  // Attached to the surface, owned by the manager
+
+    bool pendingAsync;
+    bool currentAsync;
+
+    // Listeners
+    struct wl_listener surfaceCommitListener;
+};
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Destroy_TearingSurface(struct ACNCageTearingSurface* tearingSurface);
+
+/** wp_tearing_control_manager_v1 **/
+static void Manager_GetTearingControl(struct wl_client* client,
+                                      struct wl_resource* resource, uint32_t id,
+                                      struct wl_resource* surfaceResource);
+
+/** wp_tearing_control_v1 **/
+static void TearingControl_SetPresentationHint(struct wl_client* client,
+                                               struct wl_resource* resource,
+                                               uint32_t hint);
+static void TearingControl_ResourceDestroy(struct wl_resource* resource);
+
+/** Surface addon **/
+static void Addon_Destroy(struct wlr_addon* addon);
+
+/** Commit surface **/
+static void Surface_Commit(struct wl_listener* listener, void* data);
+
+/****************************************/
+
+ACNCAGE_DISPATCH_DEFINE(Surface_Commit)
+
+static const struct wp_tearing_control_manager_v1_interface managerImpl = {
+    .destroy = ACNCageGlobal_DestroyResource,
+    .get_tearing_control = Manager_GetTearingControl,
+};
+
+static const struct wp_tearing_control_v1_interface tearingControlImpl = {
+    .set_presentation_hint = TearingControl_SetPresentationHint,
+    .destroy = ACNCageGlobal_DestroyResource,
+};
+
+static const struct wlr_addon_interface addonImpl = {
+    .name = "acncage_tearing_surface",
+    .destroy = Addon_Destroy,
+};
+
+struct ACNCageTearingManager* ACNCageTearingManager_create(
+    struct wl_display* wl_display) {
+    struct ACNCageTearingManager* manager =
+        calloc(1, sizeof(struct ACNCageTearingManager));
+    if (manager == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate ACNCageTearingManager");
+        return NULL;
+    }
+
+    if (ACNCageGlobal_init(&manager->global, wl_display,
+                           &wp_tearing_control_manager_v1_interface,
+                           TEARING_MANAGER_VERSION,
+                           &managerImpl, manager) != 0) {
+        free(manager);
+        return NULL;
+    }
+
+    return manager;
+}
+
+bool ACNCageTearing_IsAsync(struct ACNCageTearingManager* manager,
+                            struct wlr_surface* surface) {
+    if (manager == NULL || surface == NULL) return false;
+
+    struct wlr_addon* addon = wlr_addon_find(&surface->addons, manager, &addonImpl);
+    if (addon == NULL) return false;
+
+    struct ACNCageTearingSurface* tearingSurface =
+        wl_container_of(addon, tearingSurface, addon);
+    return tearingSurface->currentAsync;
+}
+
+static void Destroy_TearingSurface(struct ACNCageTearingSurface* tearingSurface) {
+    if (tearingSurface->resource != NULL)
+        wl_resource_set_user_data(tearingSurface->resource, NULL);
+
+    wlr_addon_finish(&tearingSurface->addon);
+    wl_list_remove(&tearingSurface->surfaceCommitListener.link);
+    free(tearingSurface);
+}
+
+static void Manager_GetTearingControl(struct wl_client* client,
+                                      struct wl_resource* resource, uint32_t id,
+                                      struct wl_resource* surfaceResource) {
+    struct ACNCageTearingManager* manager = wl_resource_get_user_data(resource);
+    struct wlr_surface* surface = wlr_surface_from_resource(surfaceResource);
+
+    // One tearing control object per surface
+    // Note: A destroyed one may linger until the commit resetting its hint, the
+    // new object then takes it over
+    struct ACNCageTearingSurface* tearingSurface = NULL;
+    struct wlr_addon* addon = wlr_addon_find(&surface->addons, manager, &addonImpl);
+    if (addon != NULL) {
+        tearingSurface = wl_container_of(addon, tearingSurface, addon);
+        if (tearingSurface->resource != NULL) {
+            wl_resource_post_error(
+                resource, WP_TEARING_CONTROL_MANAGER_V1_ERROR_TEARING_CONTROL_EXISTS,
+                "wp_tearing_control_v1 already exists");
+            return;
+        }
+    }
+
+    struct wl_resource* tearingResource =
+        wl_resource_create(client, &wp_tearing_control_v1_interface,
+                           wl_resource_get_version(resource), id);
+    if (tearingResource == NULL) {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    if (tearingSurface == NULL) {
+        tearingSurface = calloc(1, sizeof(struct ACNCageTearingSurface));
+        if (tearingSurface == NULL) {
+            wl_resource_destroy(tearingResource);
+            wl_client_post_no_memory(client);
+            return;
+        }
+
+        tearingSurface->surface = surface;
+        wlr_addon_init(&tearingSurface->addon, &surface->addons, manager,
+                       &addonImpl);
+
+        tearingSurface->surfaceCommitListener.notify =
+            ACNCAGE_DISPATCH(Surface_Commit);
+        wl_signal_add(&surface->events.commit,
+                      &tearingSurface->surfaceCommitListener);
+    }
+
+    tearingSurface->resource = tearingResource;
+    wl_resource_set_implementation(tearingResource, &tearingControlImpl,
+                                   tearingSurface, TearingControl_ResourceDestroy);
+}
+
+static void TearingControl_SetPresentationHint(struct wl_client* client
+                                               __attribute__((unused)),
+                                               struct wl_resource* resource,
+                                               uint32_t hint) {
+    struct ACNCageTearingSurface* tearingSurface =
+        wl_resource_get_user_data(resource);
+    if (tearingSurface == NULL) return;  // Surface destroyed, object is inert
+
+    // wp_tearing_control_v1 defines no error, values from newer versions are ignored
+    if (hint > WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC) {
+        wlr_log(WLR_DEBUG, "Ignoring unknown presentation hint %u", hint);
+        return;
+    }
+
+    tearingSurface->pendingAsync =
+        hint == WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC;
+}
+
+// Destroying the object resets the hint to vsync, on the next surface commit
+static void TearingControl_ResourceDestroy(struct wl_resource* resource) {
+    struct ACNCageTearingSurface* tearingSurface =
+        wl_resource_get_user_data(resource);
+    if (tearingSurface == NULL) return;
+
+    tearingSurface->resource = NULL;
+    tearingSurface->pendingAsync = false;
+    if (!tearingSurface->currentAsync) Destroy_TearingSurface(tearingSurface);
+}
+
+// Raise by the surface, when it goes away before its tearing control object
+static void Addon_Destroy(struct wlr_addon* addon) {
+    struct ACNCageTearingSurface* tearingSurface =
+        wl_container_of(addon, tearingSurface, addon);
+    Destroy_TearingSurface(tearingSurface);
+}
+
+// Raise by the surface, when the client commits a new surface state
+static void Surface_Commit(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageTearingSurface* tearingSurface =
+        wl_container_of(listener, tearingSurface, surfaceCommitListener);
+    tearingSurface->currentAsync = tearingSurface->pendingAsync;
+
+    // Reset to vsync by destroying the object, nothing left to track
+    if (tearingSurface->resource == NULL) Destroy_TearingSurface(tearingSurface);
+}
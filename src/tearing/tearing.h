@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+
+#include <wlr/types/wlr_compositor.h>  // wlr_surface
+
+#include "global.h"  // ACNCageGlobal
+
+// wp_tearing_control_manager_v1 global (tearing-control-v1, staging)
+struct ACNCageTearingManager {
+    struct ACNCageGlobal global;
+};
+
+/**
+ * Create the wp_tearing_control_manager_v1 global
+ * :param wl_display: display advertising the global
+ * :return: Success the manager, Error NULL
+ */
+struct ACNCageTearingManager* ACNCageTearingManager_create(
+    struct wl_display* wl_display);
+
+/**
+ * Whether the provided surface committed the async presentation hint
+ * :param manager: manager the hint was set through
+ * :param surface: surface to look up
+ * :return: true if async, false if vsync or never set
+ */
+bool ACNCageTearing_IsAsync(struct ACNCageTearingManager* manager,
+                            struct wlr_surface* surface);
@@ -0,0 +1,140 @@
+#include "trace.h"
+
+#include <errno.h>   // errno
+#include <stdio.h>   // fopen, fprintf
+#include <stdlib.h>  // calloc, free
+#include <string.h>  // strcmp, strerror
+#include <time.h>    // clock_gettime
+#include <unistd.h>  // getpid
+
+#include <wlr/util/log.h>  // wlr_log
+
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_USEC 1000
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void Record_Event(struct ACNCageTrace* trace, const char* name, char phase);
+static int Write_Trace(const struct ACNCageTrace* trace);
+
+/****************************************/
+
+int ACNCageTrace_init(struct ACNCageTrace* trace, const char* path) {
+    *trace = (struct ACNCageTrace){.path = path};
+    if (path == NULL) return 0;
+
+    trace->events = calloc(ACNCAGE_TRACE_EVENTS, sizeof(struct ACNCageTraceEvent));
+    if (trace->events == NULL) {
+        wlr_log(WLR_ERROR, "Failed to allocate trace events");
+        return -1;
+    }
+
+    trace->recording = true;
+    return 0;
+}
+
+void ACNCageTrace_finish(struct ACNCageTrace* trace) {
+    ACNCageTrace_stop(trace);
+
+    free(trace->events);
+    trace->events = NULL;
+}
+
+void ACNCageTrace_stop(struct ACNCageTrace* trace) {
+    if (!trace->recording) return;
+    trace->recording = false;
+
+    if (Write_Trace(trace) != 0) {
+        wlr_log(WLR_ERROR, "Failed to write trace to %s", trace->path);
+        return;
+    }
+    wlr_log(WLR_INFO, "Startup trace written to %s (%zu events, %zu dropped)",
+            trace->path, trace->count, trace->dropped);
+}
+
+void ACNCageTrace_begin(struct ACNCageTrace* trace, const char* name) {
+    if (trace->recording) Record_Event(trace, name, 'B');
+}
+
+void ACNCageTrace_end(struct ACNCageTrace* trace, const char* name) {
+    if (trace->recording) Record_Event(trace, name, 'E');
+}
+
+void ACNCageTrace_instant(struct ACNCageTrace* trace, const char* name) {
+    if (trace->recording) Record_Event(trace, name, 'i');
+}
+
+void ACNCageTrace_FirstInstant(struct ACNCageTrace* trace, const char* name) {
+    if (!trace->recording) return;
+
+    for (size_t i = 0; i < trace->count; i++) {
+        const struct ACNCageTraceEvent* event = &trace->events[i];
+        if (event->phase == 'i' && strcmp(event->name, name) == 0) return;
+    }
+
+    Record_Event(trace, name, 'i');
+}
+
+static void Record_Event(struct ACNCageTrace* trace, const char* name, char phase) {
+    if (trace->count == ACNCAGE_TRACE_EVENTS) {
+        trace->dropped++;
+        return;
+    }
+
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+        wlr_log(WLR_ERROR, "%s", strerror(errno));
+        return;
+    }
+
+    trace->events[trace->count++] = (struct ACNCageTraceEvent){
+        .name = name,
+        .phase = phase,
+        .nsec = (int64_t)now.tv_sec * NSEC_PER_SEC + now.tv_nsec,
+    };
+}
+
+static int Write_Trace(const struct ACNCageTrace* trace) {
+    FILE* file = fopen(trace->path, "w");
+    if (file == NULL) {
+        wlr_log(WLR_ERROR, "%s: %s", trace->path, strerror(errno));
+        return -1;
+    }
+
+    // Spans still open, innermost last
+    const char* openSpans[ACNCAGE_TRACE_EVENTS];
+    size_t depth = 0;
+
+    // Timestamps are in us, on the monotonic clock
+    int pid = getpid();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < trace->count; i++) {
+        const struct ACNCageTraceEvent* event = &trace->events[i];
+        if (event->phase == 'B') openSpans[depth++] = event->name;
+        if (event->phase == 'E' && depth > 0) --depth;
+        fprintf(file,
+                "%s\n{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"%c\","
+                "\"ts\":%.3f,\"pid\":%d,\"tid\":%d%s}",
+                i == 0 ? "" : ",", event->name, event->phase,
+                (double)event->nsec / NSEC_PER_USEC, pid, pid,
+                event->phase == 'i' ? ",\"s\":\"p\"" : "");
+    }
+
+    // Spans left open by a failed startup step end w. the last event, so that
+    // a trace showing a failure still loads
+    double lastUsec =
+        depth > 0 ? (double)trace->events[trace->count - 1].nsec / NSEC_PER_USEC : 0;
+    while (depth > 0)
+        fprintf(file,
+                ",\n{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"E\","
+                "\"ts\":%.3f,\"pid\":%d,\"tid\":%d}",
+                openSpans[--depth], lastUsec, pid, pid);
+    fprintf(file, "\n]}\n");
+
+    if (fclose(file) != 0) {
+        wlr_log(WLR_ERROR, "%s: %s", trace->path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
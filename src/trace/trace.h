@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t
+
+// Events kept in memory, until the trace is written out
+#define ACNCAGE_TRACE_EVENTS 512
+
+struct ACNCageTraceEvent {
+    const char* name;  // Must outlive the trace (e.g. a literal)
+    char phase;        // 'B'egin, 'E'nd or 'i'nstant
+    int64_t nsec;      // Monotonic clock
+};
+
+// Startup timeline, written as Chrome/Perfetto trace-event JSON
+struct ACNCageTrace {
+    const char* path;  // NULL if disabled
+    bool recording;    // Cleared once stopped, later events are ignored
+
+    struct ACNCageTraceEvent* events;
+    size_t count;
+    size_t dropped;  // Events past ACNCAGE_TRACE_EVENTS
+};
+
+/**
+ * Init the provided trace, & start recording
+ * :param trace: trace to init
+ * :param  path: trace-event JSON file to write, NULL to disable tracing
+ * :return: Success 0, Error -1
+ */
+int ACNCageTrace_init(struct ACNCageTrace* trace, const char* path);
+
+/**
+ * Stop recording (if not stopped yet), write the trace out & release it
+ * :param trace: trace to finish
+ */
+void ACNCageTrace_finish(struct ACNCageTrace* trace);
+
+/**
+ * Stop recording, & write the trace out
+ * Note: Later calls do nothing, so the 1st caller marks the end of startup
+ * Note: Spans still open, e.g. after a failed startup step, are ended there
+ * :param trace: trace to stop
+ */
+void ACNCageTrace_stop(struct ACNCageTrace* trace);
+
+/**
+ * Open a span, to be closed by ACNCageTrace_end w. the same name
+ * :param trace: trace to record into
+ * :param  name: span name
+ */
+void ACNCageTrace_begin(struct ACNCageTrace* trace, const char* name);
+
+/**
+ * Close the innermost span opened by ACNCageTrace_begin
+ * :param trace: trace to record into
+ * :param  name: span name
+ */
+void ACNCageTrace_end(struct ACNCageTrace* trace, const char* name);
+
+/**
+ * Record a point in time
+ * :param trace: trace to record into
+ * :param  name: event name
+ */
+void ACNCageTrace_instant(struct ACNCageTrace* trace, const char* name);
+
+/**
+ * Record a point in time, unless an instant event w. the same name was recorded
+ * :param trace: trace to record into
+ * :param  name: event name
+ */
+void ACNCageTrace_FirstInstant(struct ACNCageTrace* trace, const char* name);
@@ -1,6 +1,20 @@
 #include "view.h"
 
-#include <wlr/util/log.h>  // wlr_log
+#include <stdint.h>  // uint64_t, uintptr_t
+#include <stdio.h>   // snprintf
+
+#include <wlr/types/wlr_scene.h>  // wlr_scene_subsurface_tree_create
+#include <wlr/types/wlr_seat.h>   // wlr_seat
+#include <wlr/util/log.h>         // wlr_log
+
+#include "damage.h"    // ACNCageDamage_account, ACNCageDamage_log
+#include "dispatch.h"  // ACNCAGE_DISPATCH
+#include "latency.h"   // ACNCageLatency_ClientCommit
+#include "launch.h"    // ACNCageLaunch_ViewMapped
+#include "output.h"    // ACNCageOutput
+#include "server.h"    // ACNCageServer
+#include "slab.h"      // ACNCageSlab_free
+#include "trace.h"     // ACNCageTrace_instant, ACNCageTrace_stop
 
 /***** Static function declarations *****/
 
@@ -19,14 +33,49 @@ static int Create_SurfaceDestroy_Listener(struct ACNCageView* view,
                                           struct wlr_xdg_surface* wlr_xdg_surface);
 static void Surface_Destroy(struct wl_listener* listener, void* data);
 
+/** Commit surface **/
+static int Create_SurfaceCommit_Listener(struct ACNCageView* view,
+                                         struct wlr_xdg_surface* wlr_xdg_surface);
+static void Surface_Commit(struct wl_listener* listener, void* data);
+static void Hash_Subsurface(struct wlr_surface* surface, int sx, int sy,
+                            void* data);
+
 /** Fullscreen toplevel request **/
 static int Create_ToplevelFullscreenRequest_Listener(struct ACNCageView* view);
 static void Toplevel_FullscreenRequest(struct wl_listener* listener, void* data);
 
+#if WLR_HAS_XWAYLAND
+/** X11 window **/
+static int Create_Xwayland_Listeners(struct ACNCageView* view);
+static void Map_Xwayland(struct ACNCageView* view);
+static void Unmap_Xwayland(struct ACNCageView* view);
+
+/** X11 window configure request **/
+static void Xwayland_ConfigureRequest(struct wl_listener* listener, void* data);
+
+/** X11 window activate request **/
+static void Xwayland_ActivateRequest(struct wl_listener* listener, void* data);
+#endif
+
 /****************************************/
 
-int ACNCageView_CreateListeners(struct ACNCageView* view,
-                                struct wlr_xdg_surface* wlr_xdg_surface) {
+ACNCAGE_DISPATCH_DEFINE(Surface_Map)
+ACNCAGE_DISPATCH_DEFINE(Surface_Unmap)
+ACNCAGE_DISPATCH_DEFINE(Surface_Destroy)
+ACNCAGE_DISPATCH_DEFINE(Surface_Commit)
+ACNCAGE_DISPATCH_DEFINE(Toplevel_FullscreenRequest)
+#if WLR_HAS_XWAYLAND
+ACNCAGE_DISPATCH_DEFINE(Xwayland_ConfigureRequest)
+ACNCAGE_DISPATCH_DEFINE(Xwayland_ActivateRequest)
+#endif
+
+int ACNCageView_CreateListeners(struct ACNCageView* view) {
+#if WLR_HAS_XWAYLAND
+    // X11 windows raise the same events, from other objects
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) return Create_Xwayland_Listeners(view);
+#endif
+    struct wlr_xdg_surface* wlr_xdg_surface = view->wlr_xdg_toplevel->base;
+
     //  Surface map listener
     if (Create_SurfaceMap_Listener(view, wlr_xdg_surface) != 0) return -1;
 
@@ -36,6 +85,9 @@ int ACNCageView_CreateListeners(struct ACNCageView* view,
     //  Surface destroy listener
     if (Create_SurfaceDestroy_Listener(view, wlr_xdg_surface) != 0) return -1;
 
+    //  Surface commit listener
+    if (Create_SurfaceCommit_Listener(view, wlr_xdg_surface) != 0) return -1;
+
     //  Toplevel fullscreen request listener
     if (Create_ToplevelFullscreenRequest_Listener(view) != 0) return -1;
 
@@ -44,59 +96,280 @@ int ACNCageView_CreateListeners(struct ACNCageView* view,
 
 static int Create_SurfaceMap_Listener(struct ACNCageView* view,
                                       struct wlr_xdg_surface* wlr_xdg_surface) {
-    view->surfaceMapListener.notify = Surface_Map;
+    view->surfaceMapListener.notify = ACNCAGE_DISPATCH(Surface_Map);
     wl_signal_add(&wlr_xdg_surface->events.map, &view->surfaceMapListener);
     return 0;
 }
 
-// Raise by the xdg_surface, when the surface is ready to be shown
-static void Surface_Map(struct wl_listener* listener, void* data) {
+// Raise by the xdg_surface (or X11 window), when the surface is ready to be shown
+static void Surface_Map(struct wl_listener* listener,
+                        void* data __attribute__((unused))) {
     struct ACNCageView* view = wl_container_of(listener, view, surfaceMapListener);
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) Map_Xwayland(view);
+#endif
+    view->server->sceneGeneration++;
     wl_list_insert(&view->server->views, &view->link);
-    ACNCageView_focus(view, view->wlr_xdg_toplevel->base->surface);
+
+    // The first window mapped starts the app's time to first frame
+    struct ACNCageOutput* output = ACNCageView_FindOutput(view);
+    ACNCageLaunch_ViewMapped(view->server->launch,
+                             output != NULL ? output->wlr_output : NULL);
+
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        // Asked for before the window had a surface to show
+        if (view->wlr_xwayland_surface->fullscreen)
+            ACNCageView_SetFullscreen(view, true);
+
+        // Menus & tooltips leave focus to the window they belong to
+        if (view->wlr_xwayland_surface->override_redirect) {
+            ACNCageView_UpdateVisibility(view->server);
+            return;
+        }
+    }
+#endif
+    ACNCageView_focus(view, ACNCageView_GetSurface(view));
 }
 
 static int Create_SurfaceUnmap_Listener(struct ACNCageView* view,
                                         struct wlr_xdg_surface* wlr_xdg_surface) {
-    view->surfaceUnmapListener.notify = Surface_Unmap;
+    view->surfaceUnmapListener.notify = ACNCAGE_DISPATCH(Surface_Unmap);
     wl_signal_add(&wlr_xdg_surface->events.unmap, &view->surfaceUnmapListener);
     return 0;
 }
 
-static void Surface_Unmap(struct wl_listener* listener, void* data) {
+static void Surface_Unmap(struct wl_listener* listener,
+                          void* data __attribute__((unused))) {
     struct ACNCageView* view = wl_container_of(listener, view, surfaceUnmapListener);
     wl_list_remove(&view->link);
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) Unmap_Xwayland(view);
+#endif
+
+    // Views hidden beneath this one are uncovered
+    struct ACNCageOutput* output = view->fullscreenOutput;
+    ACNCageView_ReleaseOutput(view);
+    ACNCageView_UpdateVisibility(view->server);
+    if (output != NULL) ACNCageOutput_UpdateRefresh(output);
 }
 
 static int Create_SurfaceDestroy_Listener(struct ACNCageView* view,
                                           struct wlr_xdg_surface* wlr_xdg_surface) {
-    view->surfaceDestroyListener.notify = Surface_Destroy;
+    view->surfaceDestroyListener.notify = ACNCAGE_DISPATCH(Surface_Destroy);
     wl_signal_add(&wlr_xdg_surface->events.destroy, &view->surfaceDestroyListener);
     return 0;
 }
 
-static void Surface_Destroy(struct wl_listener* listener, void* data) {
+static void Surface_Destroy(struct wl_listener* listener,
+                            void* data __attribute__((unused))) {
     struct ACNCageView* view =
         wl_container_of(listener, view, surfaceDestroyListener);
+    view->server->sceneGeneration++;
+
+    const char* appId = ACNCageView_GetAppId(view);
+    char label[64];
+    snprintf(label, sizeof(label), "View %s: damage", appId != NULL ? appId : "?");
+    ACNCageDamage_log(&view->damage, label);
+
+    ACNCageView_ReleaseOutput(view);
 
     wl_list_remove(&view->surfaceMapListener.link);
     wl_list_remove(&view->surfaceUnmapListener.link);
     wl_list_remove(&view->surfaceDestroyListener.link);
+    wl_list_remove(&view->surfaceCommitListener.link);
     wl_list_remove(&view->toplevelFullscreenRequestListener.link);
+#if WLR_HAS_XWAYLAND
+    // Unlike xdg_surfaces, X11 windows don't take their scene tree w. them
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        wl_list_remove(&view->xwaylandConfigureRequestListener.link);
+        wl_list_remove(&view->xwaylandActivateRequestListener.link);
+        view->wlr_xwayland_surface->data = NULL;
+        wlr_scene_node_destroy(&view->wlr_scene_tree->node);
+    }
+#endif
+
+    ACNCageSlab_free(&view->server->viewSlab, view);
+}
+
+static int Create_SurfaceCommit_Listener(struct ACNCageView* view,
+                                         struct wlr_xdg_surface* wlr_xdg_surface) {
+    view->surfaceCommitListener.notify = ACNCAGE_DISPATCH(Surface_Commit);
+    wl_signal_add(&wlr_xdg_surface->surface->events.commit,
+                  &view->surfaceCommitListener);
+    return 0;
+}
+
+// Raise by the surface, when the client commits a new surface state
+static void Surface_Commit(struct wl_listener* listener,
+                           void* data __attribute__((unused))) {
+    struct ACNCageView* view =
+        wl_container_of(listener, view, surfaceCommitListener);
+    struct wlr_surface* surface = ACNCageView_GetSurface(view);
+    struct wlr_seat* seat = view->server->seat;
+
+    // The first client content marks the end of startup
+    if (wlr_surface_has_buffer(surface)) {
+        ACNCageTrace_instant(&view->server->trace, "first client commit");
+        ACNCageTrace_stop(&view->server->trace);
+    }
+
+    // Whole-surface damage on every commit is a usual cause of slow frames
+    if (surface->current.committed & WLR_SURFACE_STATE_BUFFER) {
+        pixman_region32_t damage;
+        pixman_region32_init(&damage);
+        wlr_surface_get_effective_damage(surface, &damage);
+        ACNCageDamage_account(&view->damage, &damage, surface->current.width,
+                              surface->current.height);
+        pixman_region32_fini(&damage);
+    }
+
+    // Resized, or w. subsurfaces moved, resized, restacked, added or removed
+    bool resized = surface->current.width != view->surfaceWidth ||
+                   surface->current.height != view->surfaceHeight;
+    uint64_t subsurfaceLayout = 14695981039346656037u;  // FNV-1a offset basis
+    wlr_surface_for_each_surface(surface, Hash_Subsurface, &subsurfaceLayout);
+    if (resized || subsurfaceLayout != view->subsurfaceLayout)
+        view->server->sceneGeneration++;
+    view->subsurfaceLayout = subsurfaceLayout;
+    // May now span (or no longer span) its whole output, opaquely
+    bool opaqueChanged =
+        surface->current.committed & WLR_SURFACE_STATE_OPAQUE_REGION;
+    if ((resized || opaqueChanged) && ACNCageView_IsMapped(view))
+        ACNCageView_UpdateVisibility(view->server);
+    view->surfaceWidth = surface->current.width;
+    view->surfaceHeight = surface->current.height;
+
+    // Only a new buffer from the client receiving input can answer it
+    if (!(surface->current.committed & WLR_SURFACE_STATE_BUFFER)) return;
+    struct wl_client* client = wl_resource_get_client(surface->resource);
+    bool focused =
+        (seat->keyboard_state.focused_client != NULL &&
+         seat->keyboard_state.focused_client->client == client) ||
+        (seat->pointer_state.focused_client != NULL &&
+         seat->pointer_state.focused_client->client == client);
+    if (!focused) return;
 
-    free(view);
+    struct ACNCageOutput* output = ACNCageView_FindOutput(view);
+    if (output != NULL)
+        ACNCageLatency_ClientCommit(&view->server->inputStamp, &output->latency);
+}
+
+// Raise by wlr_surface_for_each_surface, for every surface of the tree, bottom up
+static void Hash_Subsurface(struct wlr_surface* surface, int sx, int sy,
+                            void* data) {
+    uint64_t* hash = data;
+    const uint64_t fields[] = {(uintptr_t)surface, (uint64_t)sx, (uint64_t)sy,
+                               (uint64_t)surface->current.width,
+                               (uint64_t)surface->current.height};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+        *hash = (*hash ^ fields[i]) * 1099511628211u;  // FNV-1a prime
 }
 
 static int Create_ToplevelFullscreenRequest_Listener(struct ACNCageView* view) {
-    view->toplevelFullscreenRequestListener.notify = Toplevel_FullscreenRequest;
+    view->toplevelFullscreenRequestListener.notify =
+        ACNCAGE_DISPATCH(Toplevel_FullscreenRequest);
     wl_signal_add(&view->wlr_xdg_toplevel->events.request_fullscreen,
                   &view->toplevelFullscreenRequestListener);
     return 0;
 }
 
-static void Toplevel_FullscreenRequest(struct wl_listener* listener, void* data) {
+static void Toplevel_FullscreenRequest(struct wl_listener* listener,
+                                       void* data __attribute__((unused))) {
     struct ACNCageView* view =
         wl_container_of(listener, view, toplevelFullscreenRequestListener);
-    wlr_xdg_toplevel_set_fullscreen(view->wlr_xdg_toplevel,
-                                    view->wlr_xdg_toplevel->requested.fullscreen);
+
+    // A fullscreen view exactly covering its output can be scanned out directly
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        // Otherwise applied on map
+        if (ACNCageView_IsMapped(view))
+            ACNCageView_SetFullscreen(view, view->wlr_xwayland_surface->fullscreen);
+        return;
+    }
+#endif
+    ACNCageView_SetFullscreen(view, view->wlr_xdg_toplevel->requested.fullscreen);
+}
+
+#if WLR_HAS_XWAYLAND
+static int Create_Xwayland_Listeners(struct ACNCageView* view) {
+    struct wlr_xwayland_surface* xsurface = view->wlr_xwayland_surface;
+
+    view->surfaceMapListener.notify = ACNCAGE_DISPATCH(Surface_Map);
+    wl_signal_add(&xsurface->events.map, &view->surfaceMapListener);
+    view->surfaceUnmapListener.notify = ACNCAGE_DISPATCH(Surface_Unmap);
+    wl_signal_add(&xsurface->events.unmap, &view->surfaceUnmapListener);
+    view->surfaceDestroyListener.notify = ACNCAGE_DISPATCH(Surface_Destroy);
+    wl_signal_add(&xsurface->events.destroy, &view->surfaceDestroyListener);
+
+    // Registered on map, once the window has a surface
+    view->surfaceCommitListener.notify = ACNCAGE_DISPATCH(Surface_Commit);
+    wl_list_init(&view->surfaceCommitListener.link);
+
+    view->toplevelFullscreenRequestListener.notify =
+        ACNCAGE_DISPATCH(Toplevel_FullscreenRequest);
+    wl_signal_add(&xsurface->events.request_fullscreen,
+                  &view->toplevelFullscreenRequestListener);
+    view->xwaylandConfigureRequestListener.notify =
+        ACNCAGE_DISPATCH(Xwayland_ConfigureRequest);
+    wl_signal_add(&xsurface->events.request_configure,
+                  &view->xwaylandConfigureRequestListener);
+    view->xwaylandActivateRequestListener.notify =
+        ACNCAGE_DISPATCH(Xwayland_ActivateRequest);
+    wl_signal_add(&xsurface->events.request_activate,
+                  &view->xwaylandActivateRequestListener);
+    return 0;
+}
+
+// The surface (& its subsurfaces) joins the view's scene tree, where X11 put it
+static void Map_Xwayland(struct ACNCageView* view) {
+    struct wlr_xwayland_surface* xsurface = view->wlr_xwayland_surface;
+
+    view->surfaceTree =
+        wlr_scene_subsurface_tree_create(view->wlr_scene_tree, xsurface->surface);
+    if (view->surfaceTree == NULL)
+        wlr_log(WLR_ERROR, "Failed to attach X11 window to its scene tree");
+    if (view->fullscreenOutput == NULL)
+        wlr_scene_node_set_position(&view->wlr_scene_tree->node, xsurface->x,
+                                    xsurface->y);
+    wlr_scene_node_set_enabled(&view->wlr_scene_tree->node, true);
+
+    wl_signal_add(&xsurface->surface->events.commit, &view->surfaceCommitListener);
+}
+
+static void Unmap_Xwayland(struct ACNCageView* view) {
+    wl_list_remove(&view->surfaceCommitListener.link);
+    wl_list_init(&view->surfaceCommitListener.link);
+
+    wlr_scene_node_set_enabled(&view->wlr_scene_tree->node, false);
+    if (view->surfaceTree != NULL) wlr_scene_node_destroy(&view->surfaceTree->node);
+    view->surfaceTree = NULL;
+}
+
+// Raise by the X11 window, when it asks to be moved or resized
+static void Xwayland_ConfigureRequest(struct wl_listener* listener, void* data) {
+    struct ACNCageView* view =
+        wl_container_of(listener, view, xwaylandConfigureRequestListener);
+    struct wlr_xwayland_surface_configure_event* event = data;
+
+    // A fullscreen window keeps covering its output
+    if (view->fullscreenOutput != NULL) {
+        ACNCageView_SetFullscreen(view, true);
+        return;
+    }
+
+    wlr_xwayland_surface_configure(view->wlr_xwayland_surface, event->x, event->y,
+                                   event->width, event->height);
+    wlr_scene_node_set_position(&view->wlr_scene_tree->node, event->x, event->y);
+    if (ACNCageView_IsMapped(view)) ACNCageView_UpdateVisibility(view->server);
+}
+
+// Raise by the X11 window, when it asks for focus
+static void Xwayland_ActivateRequest(struct wl_listener* listener,
+                                     void* data __attribute__((unused))) {
+    struct ACNCageView* view =
+        wl_container_of(listener, view, xwaylandActivateRequestListener);
+    if (ACNCageView_IsMapped(view))
+        ACNCageView_focus(view, ACNCageView_GetSurface(view));
 }
+#endif
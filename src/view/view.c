@@ -1 +1,299 @@
 #include "view.h"
+
+#include <pixman.h>  // pixman_region32_contains_rectangle
+
+#include <wlr/types/wlr_seat.h>  // wlr_seat_keyboard_notify_enter
+#include <wlr/util/box.h>        // wlr_box
+
+#include "client.h"   // ACNCageClient
+#include "latency.h"  // ACNCageLatency_now
+#include "output.h"   // ACNCageOutput
+#include "server.h"   // ACNCageServer
+
+#define NSEC_PER_MSEC 1000000
+
+/***** Static function declarations *****/
+
+/** Helper functions **/
+static void View_Activate(struct ACNCageView* view, bool activated);
+static void View_Configure(struct ACNCageView* view, const struct wlr_box* box);
+static void View_SetFullscreen(struct ACNCageView* view, bool fullscreen);
+static struct wlr_box View_Geometry(struct ACNCageView* view);
+static bool View_CoversOutput(struct ACNCageView* view,
+                              struct ACNCageOutput* output);
+static void Send_Frame_Done(struct wlr_surface* surface, int sx, int sy,
+                            void* data);
+
+/****************************************/
+
+struct wlr_surface* ACNCageView_GetSurface(struct ACNCageView* view) {
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND)
+        return view->wlr_xwayland_surface->surface;
+#endif
+    return view->wlr_xdg_toplevel->base->surface;
+}
+
+bool ACNCageView_IsMapped(struct ACNCageView* view) {
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND)
+        return view->wlr_xwayland_surface->mapped;
+#endif
+    return view->wlr_xdg_toplevel->base->mapped;
+}
+
+const char* ACNCageView_GetAppId(struct ACNCageView* view) {
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND)
+        return view->wlr_xwayland_surface->class;
+#endif
+    return view->wlr_xdg_toplevel->app_id;
+}
+
+void ACNCageView_focus(struct ACNCageView* view, struct wlr_surface* surface) {
+    if (view == NULL) return;
+
+    struct ACNCageServer* server = view->server;
+    struct wlr_seat* seat = server->seat;
+
+    // Already focused
+    struct wlr_surface* prevSurface = seat->keyboard_state.focused_surface;
+    if (prevSurface == surface) return;
+
+    // Deactivate the previously focused toplevel
+    if (prevSurface != NULL && wlr_surface_is_xdg_surface(prevSurface)) {
+        struct wlr_xdg_surface* prevXdgSurface =
+            wlr_xdg_surface_from_wlr_surface(prevSurface);
+        if (prevXdgSurface->role == WLR_XDG_SURFACE_ROLE_TOPLEVEL)
+            wlr_xdg_toplevel_set_activated(prevXdgSurface->toplevel, false);
+    }
+#if WLR_HAS_XWAYLAND
+    // Or X11 window
+    if (prevSurface != NULL && wlr_surface_is_xwayland_surface(prevSurface))
+        wlr_xwayland_surface_activate(
+            wlr_xwayland_surface_from_wlr_surface(prevSurface), false);
+#endif
+
+    // Move the view to the front
+    wlr_scene_node_raise_to_top(&view->wlr_scene_tree->node);
+    wl_list_remove(&view->link);
+    wl_list_insert(&server->views, &view->link);
+    ACNCageView_UpdateVisibility(server);
+
+    // Activate the view, and send keyboard focus to it
+    View_Activate(view, true);
+
+    struct wlr_keyboard* keyboard = wlr_seat_get_keyboard(seat);
+    if (keyboard != NULL)
+        wlr_seat_keyboard_notify_enter(seat, ACNCageView_GetSurface(view),
+                                       keyboard->keycodes, keyboard->num_keycodes,
+                                       &keyboard->modifiers);
+}
+
+struct ACNCageOutput* ACNCageView_FindOutput(struct ACNCageView* view) {
+    struct ACNCageServer* server = view->server;
+
+    // Output under the center of the view
+    struct wlr_box geometry = View_Geometry(view);
+    struct wlr_output* wlr_output = wlr_output_layout_output_at(
+        server->output_layout,
+        view->wlr_scene_tree->node.x + geometry.width / 2.0,
+        view->wlr_scene_tree->node.y + geometry.height / 2.0);
+    if (wlr_output != NULL && wlr_output->data != NULL) return wlr_output->data;
+
+    // Otherwise, the first available output (mirrors only show copies)
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) {
+        if (!output->mirror) return output;
+    }
+    return NULL;
+}
+
+void ACNCageView_SetFullscreen(struct ACNCageView* view, bool fullscreen) {
+    struct ACNCageServer* server = view->server;
+
+    struct ACNCageOutput* prevOutput = view->fullscreenOutput;
+    ACNCageView_ReleaseOutput(view);
+
+    struct ACNCageOutput* output = fullscreen ? ACNCageView_FindOutput(view) : NULL;
+    if (output != NULL) {
+        // One fullscreen view per output
+        if (output->fullscreenView != NULL)
+            ACNCageView_SetFullscreen(output->fullscreenView, false);
+
+        struct wlr_box box;
+        wlr_output_layout_get_box(server->output_layout, output->wlr_output, &box);
+
+        // Cover the output exactly, so that the client buffer matches it
+        wlr_scene_node_set_position(&view->wlr_scene_tree->node, box.x, box.y);
+        wlr_scene_node_raise_to_top(&view->wlr_scene_tree->node);
+        View_Configure(view, &box);
+
+        output->fullscreenView = view;
+        view->fullscreenOutput = output;
+    } else {
+        // Let the client pick its own size
+        View_Configure(view, NULL);
+    }
+
+    View_SetFullscreen(view, output != NULL);
+    ACNCageView_UpdateVisibility(server);
+
+    // Content shown on the affected outputs changed
+    if (prevOutput != NULL && prevOutput != output)
+        ACNCageOutput_UpdateRefresh(prevOutput);
+    if (output != NULL) ACNCageOutput_UpdateRefresh(output);
+}
+
+void ACNCageView_ReleaseOutput(struct ACNCageView* view) {
+    if (view->fullscreenOutput == NULL) return;
+
+    view->fullscreenOutput->fullscreenView = NULL;
+    view->fullscreenOutput = NULL;
+}
+
+void ACNCageView_UpdateVisibility(struct ACNCageServer* server) {
+    // Stacking or visibility may have changed
+    server->sceneGeneration++;
+
+    struct ACNCageOutput* output;
+    wl_list_for_each(output, &server->outputs, link) output->covered = false;
+
+    // Walk the views from top to bottom
+    struct wlr_scene_node* node;
+    wl_list_for_each_reverse(node, &server->scene->tree.children, link) {
+        struct ACNCageView* view = node->data;
+        if (view == NULL || !ACNCageView_IsMapped(view)) continue;
+
+        if (view->fullscreenOutput != NULL) {
+            wlr_scene_node_set_enabled(node, !view->fullscreenOutput->covered);
+            view->fullscreenOutput->covered = true;
+            continue;
+        }
+
+        struct wlr_output* wlr_output =
+            wlr_output_layout_output_at(server->output_layout, node->x, node->y);
+        struct ACNCageOutput* viewOutput =
+            wlr_output != NULL ? wlr_output->data : NULL;
+        bool visible = viewOutput == NULL || !viewOutput->covered;
+        wlr_scene_node_set_enabled(node, visible);
+
+        // Opaque over the whole output, hides what's beneath like a fullscreen view
+        if (visible && viewOutput != NULL && View_CoversOutput(view, viewOutput))
+            viewOutput->covered = true;
+    }
+}
+
+void ACNCageView_SendHiddenFrameDone(struct ACNCageOutput* output,
+                                     const struct timespec* when) {
+    struct ACNCageServer* server = output->server;
+    const struct ACNCageConfig* config = &server->config;
+    int64_t now = 0;
+
+    struct ACNCageView* view;
+    wl_list_for_each(view, &server->views, link) {
+        // Visible views get theirs from the scene
+        if (view->wlr_scene_tree->node.enabled) continue;
+
+        // Nothing asked for, or answered by another output
+        struct wlr_surface* surface = ACNCageView_GetSurface(view);
+        if (wl_list_empty(&surface->current.frame_callback_list) ||
+            ACNCageView_FindOutput(view) != output)
+            continue;
+
+        bool send = config->hiddenFrames == ACNCAGE_HIDDEN_FRAMES_NORMAL;
+        if (config->hiddenFrames == ACNCAGE_HIDDEN_FRAMES_THROTTLE) {
+            if (now == 0) now = ACNCageLatency_now();
+            send = now - view->hiddenFrameNsec >=
+                   (int64_t)config->hiddenFrameIntervalMs * NSEC_PER_MSEC;
+        }
+
+        if (send) {
+            view->hiddenFrameNsec = now;
+            if (view->type == ACNCAGE_VIEW_XDG)
+                wlr_xdg_surface_for_each_surface(view->wlr_xdg_toplevel->base,
+                                                 Send_Frame_Done, (void*)when);
+            else
+                wlr_surface_for_each_surface(surface, Send_Frame_Done,
+                                             (void*)when);
+            continue;
+        }
+
+        struct ACNCageClient* client =
+            ACNCageClient_from(wl_resource_get_client(surface->resource));
+        if (client != NULL) ++client->framesSuppressed;
+    }
+}
+
+static void View_Activate(struct ACNCageView* view, bool activated) {
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        wlr_xwayland_surface_activate(view->wlr_xwayland_surface, activated);
+        return;
+    }
+#endif
+    wlr_xdg_toplevel_set_activated(view->wlr_xdg_toplevel, activated);
+}
+
+// NULL box lets the client pick its own size
+static void View_Configure(struct ACNCageView* view, const struct wlr_box* box) {
+#if WLR_HAS_XWAYLAND
+    // X11 windows keep their size, until they request another
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        if (box != NULL)
+            wlr_xwayland_surface_configure(view->wlr_xwayland_surface, box->x,
+                                           box->y, box->width, box->height);
+        return;
+    }
+#endif
+    if (box != NULL)
+        wlr_xdg_toplevel_set_size(view->wlr_xdg_toplevel, box->width, box->height);
+    else
+        wlr_xdg_toplevel_set_size(view->wlr_xdg_toplevel, 0, 0);
+}
+
+static void View_SetFullscreen(struct ACNCageView* view, bool fullscreen) {
+#if WLR_HAS_XWAYLAND
+    if (view->type == ACNCAGE_VIEW_XWAYLAND) {
+        wlr_xwayland_surface_set_fullscreen(view->wlr_xwayland_surface, fullscreen);
+        return;
+    }
+#endif
+    wlr_xdg_toplevel_set_fullscreen(view->wlr_xdg_toplevel, fullscreen);
+}
+
+// Window geometry, relative to the surface
+static struct wlr_box View_Geometry(struct ACNCageView* view) {
+#if WLR_HAS_XWAYLAND
+    // X11 windows have no client-side decorations to cut off
+    if (view->type == ACNCAGE_VIEW_XWAYLAND)
+        return (struct wlr_box){0, 0, view->wlr_xwayland_surface->width,
+                                view->wlr_xwayland_surface->height};
+#endif
+    return view->wlr_xdg_toplevel->base->current.geometry;
+}
+
+static bool View_CoversOutput(struct ACNCageView* view,
+                              struct ACNCageOutput* output) {
+    struct wlr_surface* surface = ACNCageView_GetSurface(view);
+    struct wlr_box geometry = View_Geometry(view);
+    struct wlr_box outputBox;
+    wlr_output_layout_get_box(view->server->output_layout, output->wlr_output,
+                              &outputBox);
+
+    // Output box, in surface-local coordinates
+    // Note: The surface sits at the node, offset by its window geometry
+    int x = outputBox.x - view->wlr_scene_tree->node.x + geometry.x;
+    int y = outputBox.y - view->wlr_scene_tree->node.y + geometry.y;
+    pixman_box32_t box = {x, y, x + outputBox.width, y + outputBox.height};
+    return pixman_region32_contains_rectangle(&surface->opaque_region, &box) ==
+           PIXMAN_REGION_IN;
+}
+
+static void Send_Frame_Done(struct wlr_surface* surface,
+                            int sx __attribute__((unused)),
+                            int sy __attribute__((unused)),
+                            void* data) {
+    const struct timespec* when = data;
+    wlr_surface_send_frame_done(surface, when);
+}
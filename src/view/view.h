@@ -1,21 +1,81 @@
 #pragma once
 
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint64_t
+#include <time.h>     // timespec
+
+#include <wlr/config.h>               // WLR_HAS_XWAYLAND
 #include <wlr/types/wlr_xdg_shell.h>  // wlr_xdg_toplevel
+#if WLR_HAS_XWAYLAND
+#include <wlr/xwayland.h>  // wlr_xwayland_surface
+#endif
+
+#include "damage.h"  // ACNCageDamageStats
+
+enum ACNCageViewType {
+    ACNCAGE_VIEW_XDG,       // Wayland toplevel
+    ACNCAGE_VIEW_XWAYLAND,  // X11 window
+};
 
 struct ACNCageView {
-    struct wlr_xdg_toplevel* wlr_xdg_toplevel;
+    enum ACNCageViewType type;
+    union {
+        struct wlr_xdg_toplevel* wlr_xdg_toplevel;
+#if WLR_HAS_XWAYLAND
+        struct wlr_xwayland_surface* wlr_xwayland_surface;
+#endif
+    };
     struct wl_list link;
 
     struct ACNCageServer* server;
     struct wlr_scene_tree* wlr_scene_tree;
+    struct wlr_scene_tree* surfaceTree;  // X11 windows, while mapped
+
+    // Output covered by this view, while fullscreen
+    struct ACNCageOutput* fullscreenOutput;
+
+    // Surface size as of the last commit
+    int surfaceWidth;
+    int surfaceHeight;
+    uint64_t subsurfaceLayout;  // Hash of subsurface positions, sizes & stacking
+
+    // Damage of the buffers committed by the client
+    struct ACNCageDamageStats damage;
+
+    // Last frame callback sent while hidden (throttle policy), in ns
+    int64_t hiddenFrameNsec;
 
     // Listeners
     struct wl_listener surfaceMapListener;
     struct wl_listener surfaceUnmapListener;
     struct wl_listener surfaceDestroyListener;
+    struct wl_listener surfaceCommitListener;
     struct wl_listener toplevelFullscreenRequestListener;
+    struct wl_listener xwaylandConfigureRequestListener;
+    struct wl_listener xwaylandActivateRequestListener;
 };
 
+/**
+ * Get the main surface of the provided ACNCageView
+ * :param view: view to look into
+ * :return: Surface of the toplevel or X11 window, NULL if it has none (yet)
+ */
+struct wlr_surface* ACNCageView_GetSurface(struct ACNCageView* view);
+
+/**
+ * Whether the provided ACNCageView is mapped
+ * :param view: view to look into
+ * :return: true if mapped, else false
+ */
+bool ACNCageView_IsMapped(struct ACNCageView* view);
+
+/**
+ * Get the application identifier of the provided ACNCageView
+ * :param view: view to look into
+ * :return: app_id (Wayland) or class (X11), NULL if unset
+ */
+const char* ACNCageView_GetAppId(struct ACNCageView* view);
+
 /**
  * Switch focus to the provided ACNCageView
  * :param    view: view to focus on
@@ -23,10 +83,51 @@ struct ACNCageView {
  */
 void ACNCageView_focus(struct ACNCageView* view, struct wlr_surface* surface);
 
+/**
+ * Find the output displaying the provided ACNCageView
+ * :param view: view to locate
+ * :return: Output under the center of the view, else the first output, or NULL
+ */
+struct ACNCageOutput* ACNCageView_FindOutput(struct ACNCageView* view);
+
+/**
+ * Make the provided ACNCageView cover its output, or release it
+ * :param       view: view to (un)fullscreen
+ * :param fullscreen: whether the view should cover its output
+ */
+void ACNCageView_SetFullscreen(struct ACNCageView* view, bool fullscreen);
+
+/**
+ * Release the output covered by the provided ACNCageView, if fullscreen
+ * Note: Doesn't notify the client, used when the view goes away
+ * :param view: view releasing its output
+ */
+void ACNCageView_ReleaseOutput(struct ACNCageView* view);
+
+/**
+ * Disable the scene trees of views hidden beneath a fullscreen view, or beneath
+ * a view whose opaque region spans its whole output, so that the top view is
+ * the only thing left to display on its output (which allows its buffer to be
+ * scanned out directly)
+ * Note: Also invalidates cursor hit-testing, as the stacking may have changed
+ * :param server: server hosting the views
+ */
+void ACNCageView_UpdateVisibility(struct ACNCageServer* server);
+
+/**
+ * Answer the frame callbacks of the hidden views on the provided output,
+ * following the hidden frame policy, visible views are left to the scene
+ * Note: Held back callbacks are accounted to their client
+ * :param output: output which just rendered a frame
+ * :param   when: timestamp of the frame
+ */
+void ACNCageView_SendHiddenFrameDone(struct ACNCageOutput* output,
+                                     const struct timespec* when);
+
 /**
  * Create listeners for backend events
+ * Note: X11 windows have no surface until mapped, its listener registers then
  * :param view: view hosting the listeners
  * :return: Success 0, Error -1
  */
-int ACNCageView_CreateListeners(struct ACNCageView* view,
-                                struct wlr_xdg_surface* wlr_xdg_surface);
+int ACNCageView_CreateListeners(struct ACNCageView* view);